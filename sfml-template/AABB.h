@@ -3,25 +3,25 @@
 
 struct AABB
 {
-	bool overlaps(const AABB& other) 
+	bool overlaps(const AABB& other) const
 	{ 
 		return rangeOverlaps({ lower.x, upper.x }, { other.lower.x, other.upper.x }) 
 			&& rangeOverlaps({ lower.y, upper.y }, { other.lower.y, other.upper.y });
 	}
 
-	bool contains(const AABB& other)
+	bool contains(const AABB& other) const
 	{
 		return rangeContains({ lower.x, upper.x }, { other.lower.x, other.upper.x })
 			&& rangeContains({ lower.y, upper.y }, { other.lower.y, other.upper.y });
 	}
 
-	bool contains(const vec2& p)
+	bool contains(const vec2& p) const
 	{
 		return rangeContains({ lower.x, upper.x }, p.x)
 			&& rangeContains({ lower.y, upper.y }, p.y);
 	}
 
-	AABB unionWith(const AABB& other)
+	AABB unionWith(const AABB& other) const
 	{
 		AABB u;
 
@@ -33,8 +33,39 @@ struct AABB
 		return u;
 	}
 
+	AABB enlarged(const vec2& margin) const
+	{
+		return { lower - margin, upper + margin };
+	}
+
+	// Does the segment from p to p + maxFraction * d pass through the box?
+	bool segmentOverlaps(const vec2& p, const vec2& d, real maxFraction) const
+	{
+		real tMin = 0;
+		real tMax = maxFraction;
+
+		auto clipToSlab = [&](real start, real dir, real min, real max)
+		{
+			if (dir == 0)
+			{
+				// Parallel to the slab
+				return start >= min && start <= max;
+			}
+
+			real t1 = (min - start) / dir;
+			real t2 = (max - start) / dir;
+
+			tMin = std::max(tMin, std::min(t1, t2));
+			tMax = std::min(tMax, std::max(t1, t2));
+
+			return tMin <= tMax;
+		};
+
+		return clipToSlab(p.x, d.x, lower.x, upper.x) && clipToSlab(p.y, d.y, lower.y, upper.y);
+	}
+
 	// Perimeter - 2D analogue of SA
-	real peri()
+	real peri() const
 	{
 		return 2 * (upper.x - lower.x + upper.y - lower.y);
 	}
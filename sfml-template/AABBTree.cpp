@@ -1,8 +1,9 @@
 #include "AABBTree.h"
-#include <stack>
-#include <queue>
+#include <algorithm>
+#include <array>
 
-AABBTree::AABBTree()
+AABBTree::AABBTree(const PhysicsSettings& ps):
+	ps(ps)
 {
 	rect.setOutlineColor(sf::Color::Black);
 	rect.setOutlineThickness(1);
@@ -11,453 +12,943 @@ AABBTree::AABBTree()
 
 void AABBTree::insert(RigidBody* rb)
 {
-	std::unique_ptr<Node> newNode = std::make_unique<Node>();
-	Node* newNodeObserver = newNode.get();
-	rbNodeMap.insert({ rb->id, newNodeObserver });
+	int newNode = allocateLeaf(rb);
+	insertLeaf(newNode, rootOf(newNode));
+}
 
-	newNode->rb = rb;
-	newNode->aabb = rb->getFatAABB();
-	newNode->isLeaf = true;
+void AABBTree::insertLeaf(int newNode, int& treeRoot)
+{
+	wideUpToDate = false;
 
-	if (!root)
+	if (treeRoot == nullNode)
 	{
-		root = std::move(newNode);
+		treeRoot = newNode;
 		return;
 	}
 
+	const AABB newAABB = nodes[newNode].aabb;
+
 	// Find the best sibling
-	Node* bestSibling = root.get();
-	real bestCost = insertionCost(newNode.get(), bestSibling);
+	int bestSibling = treeRoot;
+	real bestCost = insertionCost(newAABB, bestSibling);
 
-	using NodeCostPair = std::pair<Node*, real>;
 	auto compare = [](const NodeCostPair& p1, const NodeCostPair& p2)
 	{
 		// Greater than to ensure that the lowest cost pair is at the top
 		return p1.second > p2.second;
 	};
 
-	std::priority_queue<NodeCostPair, std::vector<NodeCostPair>, decltype(compare)> pq(compare);
-	pq.push({ bestSibling, bestCost });
+	pq.clear();
+	pq.push_back({ bestSibling, bestCost });
 
 	while (!pq.empty())
 	{
-		Node* n = pq.top().first;
-		pq.pop();
+		std::pop_heap(pq.begin(), pq.end(), compare);
+		int n = pq.back().first;
+		pq.pop_back();
 
-		real cost = insertionCost(newNode.get(), n);
+		real cost = insertionCost(newAABB, n);
 		if (cost < bestCost)
 		{
 			bestCost = cost;
 			bestSibling = n;
 		}
 
-		if (!n->isLeaf)
+		if (!nodes[n].isLeaf())
 		{
-			real lb = subTreeLowerBound(newNode.get(), n);
+			real lb = subTreeLowerBound(newAABB, n);
 			if (lb < bestCost)
 			{
-				pq.push({ n->child1.get(), lb });
-				pq.push({ n->child2.get(), lb });
+				pq.push_back({ nodes[n].child1, lb });
+				std::push_heap(pq.begin(), pq.end(), compare);
+
+				pq.push_back({ nodes[n].child2, lb });
+				std::push_heap(pq.begin(), pq.end(), compare);
 			}
 		}
 	}
 	
 	// Create a new parent
-	Node* oldParent = bestSibling->parent;
-	std::unique_ptr<Node> newParent = std::make_unique<Node>();
-	newParent->parent = oldParent;
-	newParent->aabb = newNode->aabb.unionWith(bestSibling->aabb); 
+	int oldParent = nodes[bestSibling].parent;
+	int newParent = allocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].child1 = bestSibling;
+	nodes[newParent].child2 = newNode;
+	refitNode(newParent);
 
-	bestSibling->parent = newParent.get();
-	newNode->parent = newParent.get();
+	nodes[bestSibling].parent = newParent;
+	nodes[newNode].parent = newParent;
 
-	if (oldParent)
+	if (oldParent != nullNode)
 	{
 		// Put the new parent in place of the sibling
-		if (oldParent->child1.get() == bestSibling)
+		if (nodes[oldParent].child1 == bestSibling)
 		{
-			newParent->child1 = std::move(oldParent->child1);
-			newParent->child2 = std::move(newNode);
-
-			oldParent->child1 = std::move(newParent);
+			nodes[oldParent].child1 = newParent;
 		}
 		else
 		{
-			newParent->child1 = std::move(oldParent->child2);
-			newParent->child2 = std::move(newNode);
-
-			oldParent->child2 = std::move(newParent);
+			nodes[oldParent].child2 = newParent;
 		}
 	}
 	else
 	{
-		// bestSibling's parent was nullptr, i.e. bestSibling was the root
-		newParent->child1 = std::move(root);
-		newParent->child2 = std::move(newNode);
-		root = std::move(newParent);
+		// bestSibling's parent was null, i.e. bestSibling was the root
+		treeRoot = newParent;
 	}
 
 	// Refit the AABBs
-	refitAABBs(newNodeObserver->parent);
+	refitAABBs(newParent);
 }
 
 void AABBTree::remove(RigidBody* rb)
 {
-	Node* rbNode = rbNodeMap[rb->id];
-	rbNodeMap.erase(rb->id);
+	int rbNode = rb->proxyIndex();
+	rb->setProxyIndex(-1);
+
+	std::erase(moveBuffer, rb);
+
+	removePairs(rb);
+
+	removeLeaf(rbNode, rootOf(rbNode));
+	freeNode(rbNode);
+	--leafCount;
+}
 
-	if (rbNode == root.get())
+void AABBTree::removeLeaf(int rbNode, int& treeRoot)
+{
+	wideUpToDate = false;
+
+	if (rbNode == treeRoot)
 	{
 		// If rb is the root, it must be the only node in the tree
 		// as each node has either 0 or 2 children
-		root.reset();
+		treeRoot = nullNode;
 		return;
 	}
 
-	Node* parent = rbNode->parent;
-	Node* grandparent = parent->parent;
+	int parent = nodes[rbNode].parent;
+	int grandparent = nodes[parent].parent;
+	int sibling = nodes[parent].child1 == rbNode ? nodes[parent].child2 : nodes[parent].child1;
 
-	if (grandparent)
+	if (grandparent != nullNode)
 	{
 		// Make the sibling's current grandparent its new parent
-		if (grandparent->child1.get() == parent)
+		if (nodes[grandparent].child1 == parent)
 		{
-			if (parent->child1.get() == rbNode)
-			{
-				grandparent->child1 = std::move(parent->child2);
-			}
-			else
-			{
-				grandparent->child1 = std::move(parent->child1);
-			}
-
-			grandparent->child1->parent = grandparent;
+			nodes[grandparent].child1 = sibling;
 		}
 		else
 		{
-			if (parent->child1.get() == rbNode)
-			{
-				grandparent->child2 = std::move(parent->child2);
-			}
-			else
-			{
-				grandparent->child2 = std::move(parent->child1);
-			}
-
-			grandparent->child2->parent = grandparent;
+			nodes[grandparent].child2 = sibling;
 		}
 
+		nodes[sibling].parent = grandparent;
+
 		refitAABBs(grandparent);
 	} 
 	else
 	{
 		// No grandparent, so sibling becomes the root
-		if (parent->child1.get() == rbNode)
-		{
-			parent->child2->parent = nullptr;
-			root = std::move(parent->child2);
-		}
-		else
-		{
-			parent->child1->parent = nullptr;
-			root = std::move(parent->child1);
-		}
+		nodes[sibling].parent = nullNode;
+		treeRoot = sibling;
 	}
+
+	freeNode(parent);
 }
 
 void AABBTree::update(RigidBody* rb)
 {
-	Node* rbNode = rbNodeMap[rb->id];
-	if (rbNode->aabb.contains(rb->getAABB()))
+	int rbNode = rb->proxyIndex();
+	if (nodes[rbNode].aabb.contains(rb->getAABB()))
 	{
 		return;
 	}
 
-	remove(rb);
+	// Reinsert the same leaf. Any pairs that no longer overlap are
+	// removed in updatePairs(), so they don't need to be removed here.
+	int& treeRoot = rootOf(rbNode);
+	removeLeaf(rbNode, treeRoot);
 	 
 	rb->updateFatAABB();
+	nodes[rbNode].aabb = rb->getFatAABB();
+	nodes[rbNode].parent = nullNode;
+	nodes[rbNode].types = rb->collTypes();
+	nodes[rbNode].collidables = rb->collidables();
 
-	insert(rb);
+	insertLeaf(rbNode, treeRoot);
+	moveBuffer.push_back(rb);
+
+	++reinserts;
 }
 
-std::vector<RigidBody*> AABBTree::getPossibleColliders(RigidBody* rb) const
+void AABBTree::updateBatch(const std::vector<RigidBody*>& bodies)
 {
-	std::vector<RigidBody*> result;
+	leafUpdates.resize(bodies.size());
 
-	std::stack<Node*> s;
-	if (root)
+	// Enlarge the leaves of any proxies that have left their fat AABBs
+	const std::vector<int>& workers = workerIndices();
+	std::for_each(std::execution::par, workers.begin(), workers.end(), [&](int w)
 	{
-		s.push(root.get());
+		auto [begin, end] = chunkRange(bodies.size(), w, workers.size());
+		for (int i = begin; i < end; ++i)
+		{
+			RigidBody* rb = bodies[i];
+			Node& leaf = nodes[rb->proxyIndex()];
+
+			if (leaf.aabb.contains(rb->getAABB()))
+			{
+				leafUpdates[i] = LeafUpdate::None;
+				continue;
+			}
+
+			AABB oldAABB = leaf.aabb;
+			rb->updateFatAABB();
+			leaf.aabb = rb->getFatAABB();
+
+			// A leaf that has moved clear of where it was is likely to be badly placed in the tree
+			leafUpdates[i] = oldAABB.overlaps(leaf.aabb) ? LeafUpdate::Refit : LeafUpdate::Reinsert;
+		}
+	});
+
+	refitLeaves.clear();
+	reinsertLeaves.clear();
+
+	for (size_t i = 0; i < bodies.size(); ++i)
+	{
+		if (leafUpdates[i] == LeafUpdate::None)
+		{
+			continue;
+		}
+
+		int leaf = bodies[i]->proxyIndex();
+		if (leafUpdates[i] == LeafUpdate::Refit)
+		{
+			refitLeaves.push_back(leaf);
+			++refits;
+		}
+		else
+		{
+			reinsertLeaves.push_back(leaf);
+			++reinserts;
+		}
+
+		moveBuffer.push_back(bodies[i]);
 	}
 
-	while (!s.empty())
+	if (refitLeaves.empty() && reinsertLeaves.empty())
 	{
-		Node* n = s.top();
-		s.pop();
+		return;
+	}
+
+	wideUpToDate = false;
+
+	for (int leaf : reinsertLeaves)
+	{
+		removeLeaf(leaf, rootOf(leaf));
+	}
 
-		if (rb != n->rb && n->aabb.overlaps(rb->getAABB()))
+	// Count how many children of each internal node need refitting. Once an
+	// ancestor has already been reached from another leaf, its own ancestors
+	// have already been counted.
+	refitCounts.resize(nodes.size(), 0);
+
+	for (int leaf : refitLeaves)
+	{
+		int n = nodes[leaf].parent;
+		while (n != nullNode && refitCounts[n]++ == 0)
 		{
-			if (n->isLeaf)
-			{
-				// Avoid checking a pair twice - only return candidates whose id
-				// is smaller than the RigidBody provided
-				if (n->rb->id < rb->id)
-				{
-					result.push_back(n->rb);
-				}
-			}
-			else
+			n = nodes[n].parent;
+		}
+	}
+
+	// Walk up from each leaf in parallel. Whichever thread arrives at a node last refits it
+	// and carries on upwards, so every node is refit exactly once, after both of its children.
+	std::for_each(std::execution::par, workers.begin(), workers.end(), [&](int w)
+	{
+		auto [begin, end] = chunkRange(refitLeaves.size(), w, workers.size());
+		for (int i = begin; i < end; ++i)
+		{
+			int n = nodes[refitLeaves[i]].parent;
+			while (n != nullNode && std::atomic_ref<int>(refitCounts[n]).fetch_sub(1, std::memory_order_acq_rel) == 1)
 			{
-				s.push(n->child1.get());
-				s.push(n->child2.get());
+				refitNode(n);
+				n = nodes[n].parent;
 			}
 		}
+	});
+
+	for (int leaf : reinsertLeaves)
+	{
+		nodes[leaf].parent = nullNode;
+		insertLeaf(leaf, rootOf(leaf));
 	}
+}
 
-	return result;
+void AABBTree::refreshFilter(RigidBody* rb)
+{
+	int leaf = rb->proxyIndex();
+	nodes[leaf].types = rb->collTypes();
+	nodes[leaf].collidables = rb->collidables();
+
+	for (int n = nodes[leaf].parent; n != nullNode; n = nodes[n].parent)
+	{
+		refitNode(n);
+	}
+
+	wideUpToDate = false;
+
+	Broadphase::refreshFilter(rb);
 }
 
-std::vector<RigidBody*> AABBTree::getPossibleContainers(const vec2& p) const
+void AABBTree::build(const std::vector<RigidBody*>& bodies)
 {
-	std::vector<RigidBody*> result;
+	for (RigidBody* rb : bodies)
+	{
+		allocateLeaf(rb);
+	}
+
+	rebuild(root, false);
+	rebuild(staticRoot, true);
+}
 
-	std::stack<Node*> s;
-	if (root)
+void AABBTree::updatePairs()
+{
+	if (++stepsSinceQualityCheck >= ps.treeQualityCheckInterval)
 	{
-		s.push(root.get());
+		stepsSinceQualityCheck = 0;
+
+		// Only the dynamic tree is checked, as the static tree changes
+		// only when bodies are added or removed
+		collectLeaves(false);
+		if (internalPerimeter(root) > ps.treeRebuildRatio * rebuiltPerimeter(buildLeaves))
+		{
+			rebuild(root, false);
+		}
 	}
 
-	while (!s.empty())
+	updateWideBVH();
+
+	addPairsForMoved([this](RigidBody* rb, std::vector<ProxyPair>& result)
 	{
-		Node* n = s.top();
-		s.pop();
+		auto addPair = [&](RigidBody* other)
+		{
+			if (other != rb)
+			{
+				result.push_back({ rb, other });
+			}
+		};
+
+		// Static proxies never need to be paired with each other, and
+		// subtrees that rb can't collide with are skipped
+		queryTree(root, rb->getFatAABB(), addPair, rb);
+
+		if (!nodes[rb->proxyIndex()].isStatic)
+		{
+			queryTree(staticRoot, rb->getFatAABB(), addPair, rb);
+		}
+	});
+}
+
+template <typename F>
+void AABBTree::cast(const vec2& p, const vec2& d, const vec2& halfExtents, real maxFraction, F&& onLeaf) const
+{
+	if (wideUpToDate)
+	{
+		auto onWideLeaf = [&](RigidBody* rb)
+		{
+			maxFraction = onLeaf(rb);
+			return maxFraction;
+		};
 
-		if (n->aabb.contains(p))
+		for (int wideTreeRoot : { wideRoot, wideStaticRoot })
 		{
-			if (n->isLeaf)
+			if (maxFraction > 0)
 			{
-				result.push_back(n->rb);
+				wide.cast(wideTreeRoot, p, d, halfExtents, maxFraction, onWideLeaf);
 			}
-			else
+		}
+
+		return;
+	}
+
+	NodeStack s;
+	pushRoots(s);
+
+	while (!s.empty())
+	{
+		const Node& n = nodes[s.top()];
+		s.pop();
+
+		if (!n.aabb.enlarged(halfExtents).segmentOverlaps(p, d, maxFraction))
+		{
+			continue;
+		}
+
+		if (n.isLeaf())
+		{
+			// Nodes are then only visited if they are hit before the new max fraction
+			maxFraction = onLeaf(n.rb);
+
+			if (maxFraction <= 0)
 			{
-				s.push(n->child1.get());
-				s.push(n->child2.get());
+				return;
 			}
 		}
+		else
+		{
+			s.push(n.child1);
+			s.push(n.child2);
+		}
 	}
+}
 
-	return result;
+void AABBTree::queryAABB(const AABB& aabb, QueryCallback callback) const
+{
+	query(aabb, callback);
 }
 
-void AABBTree::draw(sf::RenderWindow& window, real pixPerUnit)
+void AABBTree::queryPoint(const vec2& p, QueryCallback callback) const
 {
-	std::stack<Node*> s;
-	if (root)
+	query({ p, p }, callback);
+}
+
+void AABBTree::rayCast(const RayCastInput& input, RayCastCallback callback) const
+{
+	RayCastInput subInput = input;
+
+	cast(input.p1, input.p2 - input.p1, { 0, 0 }, input.maxFraction, [&](RigidBody* rb)
 	{
-		s.push(root.get());
-	}
+		subInput.maxFraction = callback(subInput, rb);
+		return subInput.maxFraction;
+	});
+}
+
+void AABBTree::shapeCast(const ShapeCastInput& input, ShapeCastCallback callback) const
+{
+	ShapeCastInput subInput = input;
+
+	// Sweep the centre of the AABB against nodes enlarged by its half extents
+	vec2 halfExtents = (input.aabb.upper - input.aabb.lower) / real(2);
+	vec2 centre = input.aabb.lower + halfExtents;
+
+	cast(centre, input.translation, halfExtents, input.maxFraction, [&](RigidBody* rb)
+	{
+		subInput.maxFraction = callback(subInput, rb);
+		return subInput.maxFraction;
+	});
+}
+
+void AABBTree::draw(sf::RenderWindow& window, real pixPerUnit)
+{
+	NodeStack s;
+	pushRoots(s);
 
 	while (!s.empty())
 	{
-		Node* n = s.top();
+		const Node& n = nodes[s.top()];
 		s.pop();
 
-		rect.setPosition(n->aabb.lower.x * pixPerUnit, n->aabb.lower.y * pixPerUnit);
+		rect.setPosition(n.aabb.lower.x * pixPerUnit, n.aabb.lower.y * pixPerUnit);
 
-		vec2 size = n->aabb.upper - n->aabb.lower;
+		vec2 size = n.aabb.upper - n.aabb.lower;
 
 		rect.setSize(sf::Vector2f(size.x * pixPerUnit, size.y * pixPerUnit));
 
 		window.draw(rect);
 
-		if (!n->isLeaf)
+		if (!n.isLeaf())
 		{
-			s.push(n->child1.get());
-			s.push(n->child2.get());
+			s.push(n.child1);
+			s.push(n.child2);
 		}
 	}
 }
 
-int AABBTree::count()
+BroadphaseStats AABBTree::getStats() const
 {
-	int result = 0;
+	BroadphaseStats stats = Broadphase::getStats();
+
+	stats.height = std::max(height(root), height(staticRoot));
+	stats.internalPerimeter = internalPerimeter(root) + internalPerimeter(staticRoot);
 
-	std::stack<Node*> s;
-	if (root)
+	return stats;
+}
+
+int AABBTree::height(int treeRoot) const
+{
+	if (treeRoot == nullNode)
 	{
-		s.push(root.get());
+		return 0;
 	}
 
-	while (!s.empty())
+	const Node& n = nodes[treeRoot];
+	return n.isLeaf() ? 1 : 1 + std::max(height(n.child1), height(n.child2));
+}
+
+int AABBTree::allocateNode()
+{
+	if (freeList == nullNode)
 	{
-		Node* n = s.top();
-		s.pop();
+		// Grow the node buffer and thread the new nodes onto the free list.
+		// Capacity doubles, so this only happens O(log n) times.
+		int oldSize = nodes.size();
+		int newSize = std::max(2 * oldSize, 16);
+
+		nodes.resize(newSize);
 
-		if (n->isLeaf)
+		for (int i = oldSize; i < newSize - 1; ++i)
 		{
-			++result;
+			nodes[i].parent = i + 1;
 		}
-		else
+
+		nodes[newSize - 1].parent = nullNode;
+		freeList = oldSize;
+	}
+
+	int n = freeList;
+	freeList = nodes[n].parent;
+
+	nodes[n] = Node{};
+
+	return n;
+}
+
+int AABBTree::allocateLeaf(RigidBody* rb)
+{
+	assert(rb->proxyIndex() == -1 && "Body already has a proxy in another broad phase");
+
+	int newNode = allocateNode();
+	rb->setProxyIndex(newNode);
+	++leafCount;
+
+	nodes[newNode].rb = rb;
+	nodes[newNode].aabb = rb->getFatAABB();
+	nodes[newNode].isStatic = rb->isStatic();
+	nodes[newNode].types = rb->collTypes();
+	nodes[newNode].collidables = rb->collidables();
+	moveBuffer.push_back(rb);
+
+	return newNode;
+}
+
+void AABBTree::updateWideBVH()
+{
+	if (!ps.useWideBVH || wideUpToDate)
+	{
+		return;
+	}
+
+	wide.clear();
+	wideRoot = wide.collapse(*this, root);
+	wideStaticRoot = wide.collapse(*this, staticRoot);
+
+	wideUpToDate = true;
+}
+
+void AABBTree::pushRoots(NodeStack& s) const
+{
+	for (int treeRoot : { root, staticRoot })
+	{
+		if (treeRoot != nullNode)
 		{
-			s.push(n->child1.get());
-			s.push(n->child2.get());
+			s.push(treeRoot);
 		}
 	}
+}
 
-	return result;
+int& AABBTree::rootOf(int leaf)
+{
+	return nodes[leaf].isStatic ? staticRoot : root;
+}
+
+void AABBTree::freeNode(int n)
+{
+	nodes[n] = Node{};
+	nodes[n].parent = freeList;
+	freeList = n;
 }
 
-real AABBTree::insertionCost(Node* toAdd, Node* sibling)
+real AABBTree::insertionCost(const AABB& toAdd, int sibling) const
 {
 	// How much extra perimeter would be added by inserting toAdd next to a given sibling?
 	
 	// Direct cost
-	real cost = toAdd->aabb.unionWith(sibling->aabb).peri();
+	real cost = toAdd.unionWith(nodes[sibling].aabb).peri();
 	
-	Node* n = sibling->parent;
-	while (n)
+	int n = nodes[sibling].parent;
+	while (n != nullNode)
 	{
 		// Inherited cost
-		cost += toAdd->aabb.unionWith(n->aabb).peri() - n->aabb.peri();
-		n = n->parent;
+		cost += toAdd.unionWith(nodes[n].aabb).peri() - nodes[n].aabb.peri();
+		n = nodes[n].parent;
 	}
 
 	return cost;
 }
 
-real AABBTree::subTreeLowerBound(Node* toAdd, Node* top)
+real AABBTree::subTreeLowerBound(const AABB& toAdd, int top) const
 {
 	// Lower bound on direct cost
-	real cost = toAdd->aabb.peri();
+	real cost = toAdd.peri();
 
-	Node* n = top;
-	while (n)
+	int n = top;
+	while (n != nullNode)
 	{
 		// Inherited cost
-		cost += toAdd->aabb.unionWith(n->aabb).peri() - n->aabb.peri();
-		n = n->parent;
+		cost += toAdd.unionWith(nodes[n].aabb).peri() - nodes[n].aabb.peri();
+		n = nodes[n].parent;
 	}
 
 	return cost;
 }
 
-void AABBTree::refitAABBs(Node* start)
+void AABBTree::refitNode(int n)
 {
-	Node* n = start;
-	while (n)
+	const Node& c1 = nodes[nodes[n].child1];
+	const Node& c2 = nodes[nodes[n].child2];
+
+	nodes[n].aabb = c1.aabb.unionWith(c2.aabb);
+	nodes[n].types = c1.types | c2.types;
+	nodes[n].collidables = c1.collidables | c2.collidables;
+}
+
+void AABBTree::refitAABBs(int start)
+{
+	int n = start;
+	while (n != nullNode)
 	{
-		n->aabb = n->child1->aabb.unionWith(n->child2->aabb);
+		refitNode(n);
 
 		rotate(n);
 
-		n = n->parent;
+		n = nodes[n].parent;
 	}
 }
 
-void AABBTree::rotate(Node* top)
+void AABBTree::rebuild(int& treeRoot, bool isStatic)
 {
-	if (top->isLeaf)
+	wideUpToDate = false;
+
+	collectLeaves(isStatic);
+
+	// Free the internal nodes, leaving the leaves where they are
+	NodeStack s;
+	if (treeRoot != nullNode)
 	{
-		return;
+		s.push(treeRoot);
 	}
 
-	Node* A = top;
-	Node* B = A->child1.get();
-	Node* C = A->child2.get();
+	while (!s.empty())
+	{
+		int n = s.top();
+		s.pop();
 
-	if (B->isLeaf && C->isLeaf)
+		if (!nodes[n].isLeaf())
+		{
+			s.push(nodes[n].child1);
+			s.push(nodes[n].child2);
+			freeNode(n);
+		}
+	}
+
+	if (buildLeaves.empty())
 	{
+		treeRoot = nullNode;
 		return;
 	}
 
-	real periB = B->aabb.peri();
-	real periC = C->aabb.peri();
+	treeRoot = buildSubtree(buildLeaves);
+	nodes[treeRoot].parent = nullNode;
+}
+
+int AABBTree::buildSubtree(std::span<int> leaves)
+{
+	if (leaves.size() == 1)
+	{
+		return leaves[0];
+	}
+
+	int split = splitLeaves(leaves);
+	int child1 = buildSubtree(leaves.first(split));
+	int child2 = buildSubtree(leaves.subspan(split));
 
-	std::vector<int> rotations;
+	int n = allocateNode();
+	nodes[n].child1 = child1;
+	nodes[n].child2 = child2;
+	refitNode(n);
 
-	Node* D = nullptr;
-	Node* E = nullptr;
-	Node* F = nullptr;
-	Node* G = nullptr;
+	nodes[child1].parent = n;
+	nodes[child2].parent = n;
+
+	return n;
+}
 
-	if (!C->isLeaf)
+real AABBTree::internalPerimeter(int treeRoot) const
+{
+	real result = 0;
+
+	NodeStack s;
+	if (treeRoot != nullNode)
 	{
-		rotations.push_back(1);
-		rotations.push_back(2);
+		s.push(treeRoot);
+	}
 
-		F = C->child1.get();
-		G = C->child2.get();
+	while (!s.empty())
+	{
+		const Node& n = nodes[s.top()];
+		s.pop();
+
+		if (!n.isLeaf())
+		{
+			result += n.aabb.peri();
+			s.push(n.child1);
+			s.push(n.child2);
+		}
 	}
-	if (!B->isLeaf)
+
+	return result;
+}
+
+real AABBTree::rebuiltPerimeter(std::span<int> leaves) const
+{
+	if (leaves.size() <= 1)
 	{
-		rotations.push_back(3);
-		rotations.push_back(4);
+		return 0;
+	}
 
-		D = B->child1.get();
-		E = B->child2.get();
+	AABB bounds = nodes[leaves[0]].aabb;
+	for (int n : leaves)
+	{
+		bounds = bounds.unionWith(nodes[n].aabb);
 	}
 
-	int bestType = 0;
-	real bestDeltaCost = 0;
+	int split = splitLeaves(leaves);
 
-	for (int type : rotations)
+	return bounds.peri() + rebuiltPerimeter(leaves.first(split)) + rebuiltPerimeter(leaves.subspan(split));
+}
+
+int AABBTree::splitLeaves(std::span<int> leaves) const
+{
+	constexpr int nBins = 16;
+
+	auto centre = [&](int n)
 	{
-		real deltaCost = 0;
+		return (nodes[n].aabb.lower + nodes[n].aabb.upper) / real(2);
+	};
+
+	// Split along the axis in which the leaf centres are most spread out
+	AABB centreBounds{ centre(leaves[0]), centre(leaves[0]) };
+	for (int n : leaves)
+	{
+		centreBounds = centreBounds.unionWith({ centre(n), centre(n) });
+	}
+
+	vec2 extent = centreBounds.upper - centreBounds.lower;
+	bool xAxis = extent.x >= extent.y;
 
-		switch (type)
+	real min = xAxis ? centreBounds.lower.x : centreBounds.lower.y;
+	real length = xAxis ? extent.x : extent.y;
+
+	int half = leaves.size() / 2;
+
+	if (length <= 0)
+	{
+		// All of the centres coincide, so any split is as good as another
+		return half;
+	}
+
+	auto binIndex = [&](int n)
+	{
+		vec2 c = centre(n);
+		int bin = nBins * ((xAxis ? c.x : c.y) - min) / length;
+		return std::min(bin, nBins - 1);
+	};
+
+	struct Bin
+	{
+		AABB aabb;
+		int count = 0;
+	};
+
+	std::array<Bin, nBins> bins;
+
+	for (int n : leaves)
+	{
+		Bin& bin = bins[binIndex(n)];
+		bin.aabb = bin.count == 0 ? nodes[n].aabb : bin.aabb.unionWith(nodes[n].aabb);
+		++bin.count;
+	}
+
+	// SAH cost of everything to the right of each bin boundary
+	std::array<real, nBins> rightCost{};
+	std::array<int, nBins> rightCount{};
+
+	AABB right;
+	int count = 0;
+	for (int i = nBins - 1; i > 0; --i)
+	{
+		if (bins[i].count > 0)
 		{
-		case 1:
-			deltaCost = B->aabb.unionWith(G->aabb).peri() - periC;
-			break;
+			right = count == 0 ? bins[i].aabb : right.unionWith(bins[i].aabb);
+			count += bins[i].count;
+		}
 
-		case 2:
-			deltaCost = B->aabb.unionWith(F->aabb).peri() - periC;
-			break;
+		rightCost[i] = count * right.peri();
+		rightCount[i] = count;
+	}
 
-		case 3:
-			deltaCost = C->aabb.unionWith(D->aabb).peri() - periB;
-			break;
+	// Sweep from the left to find the cheapest boundary
+	int bestBin = -1;
+	real bestCost = 0;
 
-		case 4:
-			deltaCost = C->aabb.unionWith(E->aabb).peri() - periB;
-			break;
+	AABB left;
+	count = 0;
+	for (int i = 0; i < nBins - 1; ++i)
+	{
+		if (bins[i].count > 0)
+		{
+			left = count == 0 ? bins[i].aabb : left.unionWith(bins[i].aabb);
+			count += bins[i].count;
+		}
+
+		if (count == 0 || rightCount[i + 1] == 0)
+		{
+			continue;
+		}
+
+		real cost = count * left.peri() + rightCost[i + 1];
+		if (bestBin == -1 || cost < bestCost)
+		{
+			bestCost = cost;
+			bestBin = i;
+		}
+	}
+
+	auto mid = std::partition(leaves.begin(), leaves.end(), [&](int n) { return binIndex(n) <= bestBin; });
+
+	return mid - leaves.begin();
+}
+
+void AABBTree::collectLeaves(bool isStatic)
+{
+	buildLeaves.clear();
+
+	int count = static_cast<int>(nodes.size());
+	for (int n = 0; n < count; ++n)
+	{
+		// Free and internal nodes have no rigid body
+		if (nodes[n].rb != nullptr && nodes[n].isStatic == isStatic)
+		{
+			buildLeaves.push_back(n);
 		}
+	}
+}
+
+void AABBTree::rotate(int top)
+{
+	Node& A = nodes[top];
+
+	if (A.isLeaf())
+	{
+		return;
+	}
+
+	int iB = A.child1;
+	int iC = A.child2;
+	Node& B = nodes[iB];
+	Node& C = nodes[iC];
 
+	if (B.isLeaf() && C.isLeaf())
+	{
+		return;
+	}
+
+	real periB = B.aabb.peri();
+	real periC = C.aabb.peri();
+
+	int bestType = 0;
+	real bestDeltaCost = 0;
+
+	auto consider = [&](int type, real deltaCost)
+	{
 		if (deltaCost < bestDeltaCost)
 		{
 			bestDeltaCost = deltaCost;
 			bestType = type;
 		}
+	};
+
+	if (!C.isLeaf())
+	{
+		const AABB& F = nodes[C.child1].aabb;
+		const AABB& G = nodes[C.child2].aabb;
+
+		consider(1, B.aabb.unionWith(G).peri() - periC);
+		consider(2, B.aabb.unionWith(F).peri() - periC);
+	}
+	if (!B.isLeaf())
+	{
+		const AABB& D = nodes[B.child1].aabb;
+		const AABB& E = nodes[B.child2].aabb;
+
+		consider(3, C.aabb.unionWith(D).peri() - periB);
+		consider(4, C.aabb.unionWith(E).peri() - periB);
+	}
+
+	if (bestType != 0)
+	{
+		++rotations;
 	}
 
 	switch (bestType)
 	{
 	case 1:
-		A->child1.swap(C->child1);
-		F->parent = A;
-		B->parent = C;
-		C->aabb = B->aabb.unionWith(G->aabb);
+	{
+		// Swap B and F
+		int iF = C.child1;
+		A.child1 = iF;
+		C.child1 = iB;
+		nodes[iF].parent = top;
+		B.parent = iC;
+		refitNode(iC);
 		break;
+	}
 
 	case 2:
-		A->child1.swap(C->child2);
-		G->parent = A;
-		B->parent = C;
-		C->aabb = B->aabb.unionWith(F->aabb);
+	{
+		// Swap B and G
+		int iG = C.child2;
+		A.child1 = iG;
+		C.child2 = iB;
+		nodes[iG].parent = top;
+		B.parent = iC;
+		refitNode(iC);
 		break;
+	}
 
 	case 3:
-		A->child2.swap(B->child2);
-		E->parent = A;
-		C->parent = B;
-		B->aabb = C->aabb.unionWith(D->aabb);
+	{
+		// Swap C and E
+		int iE = B.child2;
+		A.child2 = iE;
+		B.child2 = iC;
+		nodes[iE].parent = top;
+		C.parent = iB;
+		refitNode(iB);
 		break;
+	}
 
 	case 4:
-		A->child2.swap(B->child1);
-		D->parent = A;
-		C->parent = B;
-		B->aabb = C->aabb.unionWith(E->aabb);
+	{
+		// Swap C and D
+		int iD = B.child1;
+		A.child2 = iD;
+		B.child1 = iC;
+		nodes[iD].parent = top;
+		C.parent = iB;
+		refitNode(iB);
 		break;
 	}
+	}
 }
@@ -1,45 +1,208 @@
 #pragma once
 #include "Utils.h"
 #include "RigidBody.h"
+#include "Broadphase.h"
+#include "NodeStack.h"
+#include "WideBVH.h"
+#include <span>
+#include <atomic>
 
-class AABBTree
+class AABBTree : public Broadphase
 {
 public:
-	AABBTree();
+	AABBTree(const PhysicsSettings& ps);
 
-	void insert(RigidBody* rb);
-	void remove(RigidBody* rb);
-	void update(RigidBody* rb);
+	void insert(RigidBody* rb) override;
+	void remove(RigidBody* rb) override;
+	void update(RigidBody* rb) override;
 
-	std::vector<RigidBody*> getPossibleColliders(RigidBody* rb) const;
-	std::vector<RigidBody*> getPossibleContainers(const vec2& p) const;
+	// Proxies that have left their fat AABBs have their leaves enlarged in place, and the
+	// internal nodes above them are then refit bottom-up in parallel. Only leaves that have
+	// moved clear of their previous fat AABB are removed and reinserted.
+	void updateBatch(const std::vector<RigidBody*>& bodies) override;
 
-	void draw(sf::RenderWindow& window, real pixPerUnit);
+	void refreshFilter(RigidBody* rb) override;
 
-	int count();
+	// Add the new proxies as leaves, then rebuild the whole tree top-down
+	void build(const std::vector<RigidBody*>& bodies) override;
+
+	// Query the tree for proxies that were (re)inserted since the last call, and
+	// discard any stored pairs whose fat AABBs no longer overlap.
+	// Every so often, the tree is also rebuilt if its quality has degraded.
+	void updatePairs() override;
+
+	// Calls callback(rb) for every proxy whose fat AABB overlaps aabb. If filter is given,
+	// subtrees containing nothing that filter can collide with are skipped.
+	template <typename F>
+	void query(const AABB& aabb, F&& callback, const RigidBody* filter = nullptr) const;
+
+	// As above, but only searching the tree with the given root
+	template <typename F>
+	void queryTree(int treeRoot, const AABB& aabb, F&& callback, const RigidBody* filter = nullptr) const;
+
+	void queryAABB(const AABB& aabb, QueryCallback callback) const override;
+	void queryPoint(const vec2& p, QueryCallback callback) const override;
+
+	// Only nodes hit before the current max fraction are visited
+	void rayCast(const RayCastInput& input, RayCastCallback callback) const override;
+	void shapeCast(const ShapeCastInput& input, ShapeCastCallback callback) const override;
+
+	void draw(sf::RenderWindow& window, real pixPerUnit) override;
+
+	int count() const override { return leafCount; }
+
+	BroadphaseStats getStats() const override;
 
 private:
+	friend class WideBVH;
+
 	struct Node;
 
-	real insertionCost(Node* toAdd, Node* sibling);
-	real subTreeLowerBound(Node* toAdd, Node* top);
-	void refitAABBs(Node* start);
-	void rotate(Node* top);
+	// Collapse both trees into the wide BVH, if enabled and they have changed since it was last built
+	void updateWideBVH();
+
+	void pushRoots(NodeStack& s) const;
+
+	// Traverse the nodes hit by the segment from p to p + maxFraction * d, with each node enlarged
+	// by halfExtents. onLeaf(rb) returns the new max fraction, and the traversal ends if it's zero.
+	template <typename F>
+	void cast(const vec2& p, const vec2& d, const vec2& halfExtents, real maxFraction, F&& onLeaf) const;
+
+	// Index used in place of a null pointer
+	static constexpr int nullNode = -1;
+
+	int allocateNode();
+	void freeNode(int n);
+
+	// Allocate a leaf for rb and add it to the move buffer, without linking it into a tree
+	int allocateLeaf(RigidBody* rb);
+
+	int& rootOf(int leaf);
+
+	void insertLeaf(int leaf, int& treeRoot);
+	void removeLeaf(int leaf, int& treeRoot);
+
+	real insertionCost(const AABB& toAdd, int sibling) const;
+	real subTreeLowerBound(const AABB& toAdd, int top) const;
+	// Recompute the AABB and collision types of an internal node from its children
+	void refitNode(int n);
+	void refitAABBs(int start);
+	void rotate(int top);
+
+	// Discard all internal nodes of one tree and rebuild it top-down from its leaves
+	void rebuild(int& treeRoot, bool isStatic);
+	int buildSubtree(std::span<int> leaves);
+
+	// Total perimeter of the internal nodes of a tree, and of the tree
+	// that rebuild() would produce, without actually building it
+	real internalPerimeter(int treeRoot) const;
+	real rebuiltPerimeter(std::span<int> leaves) const;
+
+	// Reorder leaves about a binned SAH split, and return the size of the first part
+	int splitLeaves(std::span<int> leaves) const;
 
-	std::unique_ptr<Node> root;
-	std::map<idType, Node*> rbNodeMap;
+	// Fill buildLeaves with the leaves belonging to either the static or the dynamic tree
+	void collectLeaves(bool isStatic);
+
+	int height(int treeRoot) const;
+
+	const PhysicsSettings& ps;
+
+	int leafCount = 0;
+
+	int stepsSinceQualityCheck = 0;
+
+	// All nodes live in one contiguous buffer and refer to each other by index.
+	// Unused nodes are chained together in a free list.
+	// Static proxies are kept in a separate tree, which shares the same buffer.
+	std::vector<Node> nodes;
+	int root = nullNode;
+	int staticRoot = nullNode;
+	int freeList = nullNode;
+
+	// Reused by insert() to avoid allocating a new priority queue every time
+	using NodeCostPair = std::pair<int, real>;
+	std::vector<NodeCostPair> pq;
+
+	// Leaf indices, reordered in place during a bulk build
+	std::vector<int> buildLeaves;
+
+	// Used by updateBatch()
+	enum class LeafUpdate : uint8_t { None, Refit, Reinsert };
+	std::vector<LeafUpdate> leafUpdates;
+	std::vector<int> refitLeaves;
+	std::vector<int> reinsertLeaves;
+
+	// Number of children of each internal node still waiting to be refit. All zero between updates.
+	std::vector<int> refitCounts;
+
+	// Optional 4-ary copy of the trees, used for queries whenever it's up to date
+	WideBVH wide;
+	int wideRoot = WideBVH::nullNode;
+	int wideStaticRoot = WideBVH::nullNode;
+	bool wideUpToDate = false;
 
 	sf::RectangleShape rect;
 };
 
 struct AABBTree::Node
 {
+	bool isLeaf() const { return child1 == nullNode; }
+
 	RigidBody* rb = nullptr;
 	AABB aabb;
 
-	bool isLeaf = false;
+	// Whether a leaf belongs to the static tree
+	bool isStatic = false;
+
+	// OR of the collision types and collidable types of every body in the subtree
+	collType types = 0;
+	collType collidables = 0;
+
+	// For a node in the free list, parent holds the index of the next free node
+	int parent = nullNode;
+	int child1 = nullNode;
+	int child2 = nullNode;
+};
+
+template <typename F>
+void AABBTree::query(const AABB& aabb, F&& callback, const RigidBody* filter) const
+{
+	queryTree(root, aabb, callback, filter);
+	queryTree(staticRoot, aabb, callback, filter);
+}
+
+template <typename F>
+void AABBTree::queryTree(int treeRoot, const AABB& aabb, F&& callback, const RigidBody* filter) const
+{
+	if (wideUpToDate)
+	{
+		wide.query(treeRoot == root ? wideRoot : wideStaticRoot, aabb, callback, filter);
+		return;
+	}
+
+	NodeStack s;
+	if (treeRoot != nullNode)
+	{
+		s.push(treeRoot);
+	}
+
+	while (!s.empty())
+	{
+		const Node& n = nodes[s.top()];
+		s.pop();
 
-	Node* parent = nullptr;
-	std::unique_ptr<Node> child1 = nullptr;
-	std::unique_ptr<Node> child2 = nullptr;
-};
\ No newline at end of file
+		if (n.aabb.overlaps(aabb) && (!filter || filter->canCollideWithGroup(n.types, n.collidables)))
+		{
+			if (n.isLeaf())
+			{
+				callback(n.rb);
+			}
+			else
+			{
+				s.push(n.child1);
+				s.push(n.child2);
+			}
+		}
+	}
+}
\ No newline at end of file
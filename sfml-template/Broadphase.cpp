@@ -0,0 +1,122 @@
+#include "Broadphase.h"
+
+void Broadphase::build(const std::vector<RigidBody*>& bodies)
+{
+	for (RigidBody* rb : bodies)
+	{
+		insert(rb);
+	}
+}
+
+void Broadphase::updateBatch(const std::vector<RigidBody*>& bodies)
+{
+	for (RigidBody* rb : bodies)
+	{
+		update(rb);
+	}
+}
+
+void Broadphase::refreshFilter(RigidBody* rb)
+{
+	// Pairs that can no longer collide are filtered out later,
+	// but pairs that now can need to be looked for again
+	moveBuffer.push_back(rb);
+}
+
+BroadphaseStats Broadphase::getStats() const
+{
+	BroadphaseStats stats;
+
+	stats.proxies = count();
+	stats.reinserts = reinserts;
+	stats.refits = refits;
+	stats.rotations = rotations;
+	stats.candidatePairs = pairs.size();
+
+	return stats;
+}
+
+void Broadphase::resetStepStats()
+{
+	reinserts = 0;
+	refits = 0;
+	rotations = 0;
+}
+
+void Broadphase::rayCast(const RayCastInput& input, RayCastCallback callback) const
+{
+	RayCastInput subInput = input;
+	vec2 d = input.p2 - input.p1;
+
+	AABB bounds{ input.p1, input.p1 };
+	bounds = bounds.unionWith({ input.p1 + input.maxFraction * d, input.p1 + input.maxFraction * d });
+
+	queryAABB(bounds, [&](RigidBody* rb)
+	{
+		if (subInput.maxFraction > 0 && rb->getFatAABB().segmentOverlaps(input.p1, d, subInput.maxFraction))
+		{
+			subInput.maxFraction = callback(subInput, rb);
+		}
+	});
+}
+
+void Broadphase::shapeCast(const ShapeCastInput& input, ShapeCastCallback callback) const
+{
+	ShapeCastInput subInput = input;
+	vec2 d = input.translation;
+
+	// Sweep the centre of the AABB against proxies enlarged by its half extents
+	vec2 halfExtents = (input.aabb.upper - input.aabb.lower) / real(2);
+	vec2 centre = input.aabb.lower + halfExtents;
+
+	AABB bounds = input.aabb.unionWith({ input.aabb.lower + input.maxFraction * d, input.aabb.upper + input.maxFraction * d });
+
+	queryAABB(bounds, [&](RigidBody* rb)
+	{
+		if (subInput.maxFraction > 0 && rb->getFatAABB().enlarged(halfExtents).segmentOverlaps(centre, d, subInput.maxFraction))
+		{
+			subInput.maxFraction = callback(subInput, rb);
+		}
+	});
+}
+
+std::vector<RigidBody*> Broadphase::getPossibleContainers(const vec2& p) const
+{
+	std::vector<RigidBody*> result;
+
+	queryPoint(p, [&](RigidBody* rb)
+	{
+		result.push_back(rb);
+	});
+
+	return result;
+}
+
+void Broadphase::getPairs(std::vector<ProxyPair>& result) const
+{
+	for (const auto& [ids, pair] : pairs)
+	{
+		result.push_back({ pair.rb1, pair.rb2, &pair.cache });
+	}
+}
+
+void Broadphase::addPair(RigidBody* rbA, RigidBody* rbB)
+{
+	RigidBody* rb1 = rbA->id < rbB->id ? rbA : rbB;
+	RigidBody* rb2 = rbA->id < rbB->id ? rbB : rbA;
+
+	pairs.insert({ { rb1->id, rb2->id }, { rb1, rb2, {} } });
+}
+
+void Broadphase::removePairs(const RigidBody* rb)
+{
+	std::erase_if(pairs, [rb](const auto& p) { return p.second.rb1 == rb || p.second.rb2 == rb; });
+}
+
+void Broadphase::removeStalePairs()
+{
+	std::erase_if(pairs, [](const auto& p)
+	{
+		return !p.second.rb1->getFatAABB().overlaps(p.second.rb2->getFatAABB());
+	});
+}
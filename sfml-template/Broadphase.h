@@ -0,0 +1,180 @@
+#pragma once
+#include "Utils.h"
+#include "RigidBody.h"
+#include "FunctionRef.h"
+#include <map>
+
+// A pair of proxies whose fat AABBs overlap, ordered so that rb1->id < rb2->id
+struct ProxyPair
+{
+	RigidBody* rb1 = nullptr;
+	RigidBody* rb2 = nullptr;
+
+	// Owned by the broad phase, and valid until the pair is removed from it
+	PairCache* cache = nullptr;
+};
+
+// Segment from p1 to p1 + maxFraction * (p2 - p1)
+struct RayCastInput
+{
+	vec2 p1, p2;
+	real maxFraction = 1;
+};
+
+// AABB swept from its starting position to aabb + maxFraction * translation
+struct ShapeCastInput
+{
+	AABB aabb;
+	vec2 translation;
+	real maxFraction = 1;
+};
+
+// Metrics describing the structure of a broad phase and its activity during the current step
+struct BroadphaseStats
+{
+	int proxies = 0;
+
+	// Only meaningful for trees
+	int height = 0;
+	real internalPerimeter = 0;
+	int rotations = 0;
+
+	// Proxies that left their fat AABBs and were reinserted, or refit in place
+	int reinserts = 0;
+	int refits = 0;
+
+	// Pairs with overlapping fat AABBs, before any filtering by Game
+	int candidatePairs = 0;
+};
+
+// Called for each proxy found by a query
+using QueryCallback = FunctionRef<void(RigidBody*)>;
+
+// Called for each proxy whose fat AABB is hit by the ray or swept AABB, within the current
+// maxFraction. The value returned becomes the new maxFraction, so returning input.maxFraction
+// continues the cast unchanged, a smaller fraction clips it, and zero ends it immediately.
+using RayCastCallback = FunctionRef<real(const RayCastInput& input, RigidBody* rb)>;
+using ShapeCastCallback = FunctionRef<real(const ShapeCastInput& input, RigidBody* rb)>;
+
+// Interface shared by the broad phase implementations (AABBTree, SweepAndPrune,
+// SpatialHashGrid and HybridBroadphase)
+class Broadphase
+{
+public:
+	virtual ~Broadphase() = default;
+
+	virtual void insert(RigidBody* rb) = 0;
+	virtual void remove(RigidBody* rb) = 0;
+	virtual void update(RigidBody* rb) = 0;
+
+	// Update many proxies at once, e.g. every body at the start of a step.
+	// By default they are updated one at a time.
+	virtual void updateBatch(const std::vector<RigidBody*>& bodies);
+
+	// Insert many proxies at once, e.g. when loading a scene. By default they are
+	// inserted one at a time, but implementations may build their structure in one pass.
+	virtual void build(const std::vector<RigidBody*>& bodies);
+
+	// Call after changing the collision types of a body that has already been inserted
+	virtual void refreshFilter(RigidBody* rb);
+
+	// Bring the stored pairs up to date after any calls to insert(), remove() or update()
+	virtual void updatePairs() = 0;
+
+	// Append every stored pair to result
+	virtual void getPairs(std::vector<ProxyPair>& result) const;
+
+	// Find the proxies whose fat AABBs overlap aabb, or contain p
+	virtual void queryAABB(const AABB& aabb, QueryCallback callback) const = 0;
+	virtual void queryPoint(const vec2& p, QueryCallback callback) const = 0;
+
+	// By default, these test every proxy overlapping the bounds of the whole cast
+	virtual void rayCast(const RayCastInput& input, RayCastCallback callback) const;
+	virtual void shapeCast(const ShapeCastInput& input, ShapeCastCallback callback) const;
+
+	std::vector<RigidBody*> getPossibleContainers(const vec2& p) const;
+
+	virtual void draw(sf::RenderWindow& window, real pixPerUnit) = 0;
+
+	virtual int count() const = 0;
+
+	virtual BroadphaseStats getStats() const;
+
+	// Reset the counters of activity during a step (reinserts, refits and rotations)
+	virtual void resetStepStats();
+
+protected:
+	// Store the pair, ordered by id, if it isn't already present
+	void addPair(RigidBody* rbA, RigidBody* rbB);
+
+	// Remove any pairs involving rb
+	void removePairs(const RigidBody* rb);
+
+	// Remove any pairs whose fat AABBs no longer overlap
+	void removeStalePairs();
+
+	// Calls findPairs(rb, buffer) for each proxy in the move buffer, in parallel, with each worker
+	// writing into its own buffer. The buffers are then merged into the pair set in worker order,
+	// so the result doesn't depend on thread timing, and the move buffer is cleared.
+	template <typename F>
+	void addPairsForMoved(F&& findPairs);
+
+	// Persistent set of candidate pairs, kept until their fat AABBs stop overlapping
+	struct StoredPair
+	{
+		RigidBody* rb1;
+		RigidBody* rb2;
+
+		// Written by the narrow phase through ProxyPair::cache
+		mutable PairCache cache;
+	};
+
+	std::map<idPair, StoredPair> pairs;
+
+	// Proxies that have been inserted or reinserted since the last call to updatePairs()
+	std::vector<RigidBody*> moveBuffer;
+
+	int reinserts = 0;
+	int refits = 0;
+	int rotations = 0;
+
+private:
+	std::vector<std::vector<ProxyPair>> pairBuffers;
+};
+
+template <typename F>
+void Broadphase::addPairsForMoved(F&& findPairs)
+{
+	// Pairs can only stop overlapping if one of their proxies was reinserted
+	if (moveBuffer.empty())
+	{
+		return;
+	}
+
+	removeStalePairs();
+
+	const std::vector<int>& workers = workerIndices();
+	pairBuffers.resize(workers.size());
+
+	std::for_each(std::execution::par, workers.begin(), workers.end(), [&](int w)
+	{
+		pairBuffers[w].clear();
+
+		auto [begin, end] = chunkRange(moveBuffer.size(), w, workers.size());
+		for (int i = begin; i < end; ++i)
+		{
+			findPairs(moveBuffer[i], pairBuffers[w]);
+		}
+	});
+
+	// If both proxies of a pair moved, it will be found twice, but the pair set ignores duplicates
+	for (const auto& buffer : pairBuffers)
+	{
+		for (const ProxyPair& p : buffer)
+		{
+			addPair(p.rb1, p.rb2);
+		}
+	}
+
+	moveBuffer.clear();
+}
@@ -3,7 +3,7 @@
 
 Circle::Circle(const PhysicsSettings& ps, real rad, real mInv):
 	rad(rad),
-	RigidBody(ps, mInv)
+	RigidBody(ps, Shape::Circle, mInv)
 {
 	setIInv(2 * mInv / (rad * rad));
 	initShape();
@@ -31,21 +31,32 @@ void Circle::draw(sf::RenderWindow& window, real fraction, bool debug, sf::Text*
 	}
 }
 
-std::unique_ptr<ContactConstraint> Circle::checkCollision(ConvexPolygon* other)
+bool Circle::checkCollision(Circle* other, real margin, ContactManifold& manifold)
 {
-	return other->checkCollision(this);
-}
-
-std::unique_ptr<ContactConstraint> Circle::checkCollision(Circle* other)
-{
-	real radiusSum = rad + other->rad;
-	if (magSquared(other->position() - position()) < radiusSum * radiusSum)
+	real maxDist = rad + other->rad + margin;
+	if (magSquared(other->position() - position()) < maxDist * maxDist)
 	{
-		return std::make_unique<CircleCircleContact>(this, other, ps);
+		vec2 n = other->position() - position();
+
+		if (!isZero(n))
+		{
+			n = normalise(n);
+		}
+
+		vec2 furthestPoint1 = furthestPoint(n);
+		vec2 furthestPoint2 = other->furthestPoint(-n);
+
+		manifold.type = ContactType::CircleCircle;
+		manifold.rb1 = this;
+		manifold.rb2 = other;
+		manifold.normal = n;
+		manifold.penetration = dot(furthestPoint2 - furthestPoint1, n);
+		manifold.point = static_cast<real>(0.5) * (furthestPoint1 + furthestPoint2);
+		return true;
 	}
 	else
 	{
-		return nullptr;
+		return false;
 	}
 }
 
@@ -60,12 +71,6 @@ void Circle::updateAABB()
 	aabb.upper = { position().x + rad, position().y + rad };
 }
 
-void Circle::updateFatAABB()
-{
-	aabbFat.lower = { position().x - rad - ps.aabbFattening, position().y - rad - ps.aabbFattening };
-	aabbFat.upper = { position().x + rad + ps.aabbFattening, position().y + rad + ps.aabbFattening };
-}
-
 vec2 Circle::furthestPoint(const vec2& d) const
 {
 	return position() + d * rad;
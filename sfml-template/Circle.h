@@ -12,13 +12,11 @@ public:
 
 	void draw(sf::RenderWindow& window, real fraction, bool debug, sf::Text* text) override;
 
-	std::unique_ptr<ContactConstraint> checkCollision(RigidBody* other) override { return other->checkCollision(this); }
-	std::unique_ptr<ContactConstraint> checkCollision(ConvexPolygon* other) override;
-	std::unique_ptr<ContactConstraint> checkCollision(Circle* other) override;
+	// Returns whether the bodies are in contact or less than margin apart, and if so fills in manifold
+	bool checkCollision(Circle* other, real margin, ContactManifold& manifold);
 
 	bool pointInside(const vec2& p) const override;
 	void updateAABB() override;
-	void updateFatAABB() override;
 
 	// No data to update on move
 	void onMove() override { }
@@ -0,0 +1,46 @@
+#include "CircleBatch.h"
+#include "Circle.h"
+
+void CircleBatch::clear()
+{
+	c1.clear();
+	c2.clear();
+	x1.clear();
+	y1.clear();
+	r1.clear();
+	x2.clear();
+	y2.clear();
+	r2.clear();
+	margin.clear();
+}
+
+void CircleBatch::add(Circle* circle1, Circle* circle2)
+{
+	c1.push_back(circle1);
+	c2.push_back(circle2);
+
+	x1.push_back(circle1->position().x);
+	y1.push_back(circle1->position().y);
+	r1.push_back(circle1->radius());
+
+	x2.push_back(circle2->position().x);
+	y2.push_back(circle2->position().y);
+	r2.push_back(circle2->radius());
+
+	margin.push_back(circle1->speculativeMargin(circle2));
+}
+
+bool CircleBatch::collideOne(int i, ContactManifold& manifold) const
+{
+	return c1[i]->checkCollision(c2[i], margin[i], manifold);
+}
+
+void CircleBatch::fillManifold(int i, const vec2& n, real penetration, const vec2& point, ContactManifold& manifold) const
+{
+	manifold.type = ContactType::CircleCircle;
+	manifold.rb1 = c1[i];
+	manifold.rb2 = c2[i];
+	manifold.normal = n;
+	manifold.penetration = penetration;
+	manifold.point = point;
+}
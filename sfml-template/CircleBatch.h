@@ -0,0 +1,109 @@
+#pragma once
+#include "Utils.h"
+#include "ContactManifold.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define CIRCLE_BATCH_SSE
+#include <xmmintrin.h>
+static_assert(std::is_same_v<real, float>, "The SSE path of CircleBatch assumes single precision");
+#endif
+
+class Circle;
+
+// Circle-circle pairs gathered into structure-of-arrays form, so that they can be tested four
+// at a time with SSE. The results match the scalar test in Circle::checkCollision exactly.
+class CircleBatch
+{
+public:
+	void clear();
+
+	// c1 and c2 become rb1 and rb2 of the contact. The speculative margin is worked out here.
+	void add(Circle* c1, Circle* c2);
+
+	int size() const { return static_cast<int>(c1.size()); }
+	Circle* first(int i) const { return c1[i]; }
+	Circle* second(int i) const { return c2[i]; }
+
+	// Test the pairs with indices in [begin, end), and call onHit(i, manifold) for each one in contact
+	template <typename F>
+	void collide(int begin, int end, F&& onHit) const;
+
+private:
+	bool collideOne(int i, ContactManifold& manifold) const;
+	void fillManifold(int i, const vec2& n, real penetration, const vec2& point, ContactManifold& manifold) const;
+
+	std::vector<Circle*> c1, c2;
+	std::vector<real> x1, y1, r1, x2, y2, r2, margin;
+};
+
+template <typename F>
+void CircleBatch::collide(int begin, int end, F&& onHit) const
+{
+	int i = begin;
+	ContactManifold manifold;
+
+#ifdef CIRCLE_BATCH_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 px1 = _mm_loadu_ps(&x1[i]), py1 = _mm_loadu_ps(&y1[i]), rad1 = _mm_loadu_ps(&r1[i]);
+		__m128 px2 = _mm_loadu_ps(&x2[i]), py2 = _mm_loadu_ps(&y2[i]), rad2 = _mm_loadu_ps(&r2[i]);
+		__m128 maxDist = _mm_add_ps(_mm_add_ps(rad1, rad2), _mm_loadu_ps(&margin[i]));
+
+		__m128 dx = _mm_sub_ps(px2, px1);
+		__m128 dy = _mm_sub_ps(py2, py1);
+		__m128 distSquared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+		int hits = _mm_movemask_ps(_mm_cmplt_ps(distSquared, _mm_mul_ps(maxDist, maxDist)));
+
+		if (hits == 0)
+		{
+			continue;
+		}
+
+		// Normal from circle 1 to circle 2, left as zero if the centres coincide
+		__m128 nonZero = _mm_or_ps(_mm_cmpneq_ps(dx, zero), _mm_cmpneq_ps(dy, zero));
+		__m128 dist = _mm_sqrt_ps(distSquared);
+		__m128 nx = _mm_or_ps(_mm_and_ps(nonZero, _mm_div_ps(dx, dist)), _mm_andnot_ps(nonZero, dx));
+		__m128 ny = _mm_or_ps(_mm_and_ps(nonZero, _mm_div_ps(dy, dist)), _mm_andnot_ps(nonZero, dy));
+
+		// Furthest points of each circle along the normal, towards the other circle
+		__m128 fx1 = _mm_add_ps(px1, _mm_mul_ps(nx, rad1));
+		__m128 fy1 = _mm_add_ps(py1, _mm_mul_ps(ny, rad1));
+		__m128 fx2 = _mm_add_ps(px2, _mm_mul_ps(_mm_xor_ps(nx, signBit), rad2));
+		__m128 fy2 = _mm_add_ps(py2, _mm_mul_ps(_mm_xor_ps(ny, signBit), rad2));
+
+		// The contact point is in the middle of the colliding region
+		__m128 cx = _mm_mul_ps(half, _mm_add_ps(fx1, fx2));
+		__m128 cy = _mm_mul_ps(half, _mm_add_ps(fy1, fy2));
+		__m128 penetration = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(fx2, fx1), nx), _mm_mul_ps(_mm_sub_ps(fy2, fy1), ny));
+
+		alignas(16) real out[5][4];
+		_mm_store_ps(out[0], nx);
+		_mm_store_ps(out[1], ny);
+		_mm_store_ps(out[2], penetration);
+		_mm_store_ps(out[3], cx);
+		_mm_store_ps(out[4], cy);
+
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			if (hits & (1 << lane))
+			{
+				fillManifold(i + lane, { out[0][lane], out[1][lane] }, out[2][lane], { out[3][lane], out[4][lane] }, manifold);
+				onHit(i + lane, manifold);
+			}
+		}
+	}
+#endif
+
+	for (; i < end; ++i)
+	{
+		if (collideOne(i, manifold))
+		{
+			onHit(i, manifold);
+		}
+	}
+}
@@ -1,17 +1,26 @@
 #include "CircleCircleContact.h"
 
-CircleCircleContact::CircleCircleContact(Circle* c1, Circle* c2, const PhysicsSettings& ps):
-	c1(c1), c2(c2),
-	ContactConstraint(ps, c1, c2)
+CircleCircleContact::CircleCircleContact(const ContactManifold& m, const PhysicsSettings& ps):
+	c1(static_cast<Circle*>(m.rb1)), c2(static_cast<Circle*>(m.rb2)),
+	ContactConstraint(ps, ContactType::CircleCircle, m.rb1, m.rb2)
 {
-	
+	setFeatures(m);
+}
+
+void CircleCircleContact::setFeatures(const ContactManifold& m)
+{
+	initialNormal = m.normal;
+	initialPenetration = m.penetration;
+	initialPoint = m.point;
 }
 
 void CircleCircleContact::initPoints()
 {
-	updateNormal();
-	contactPoints.resize(1);
-	rebuildPoint(contactPoints.front());
+	n = initialNormal;
+
+	ContactPoint& cp = addPoint();
+	cp.point = initialPoint;
+	cp.penetration = initialPenetration;
 }
 
 void CircleCircleContact::rebuildPoint(ContactPoint& cp)
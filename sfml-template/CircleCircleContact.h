@@ -6,14 +6,20 @@
 class CircleCircleContact : public ContactConstraint
 {
 public:
-	CircleCircleContact(Circle* c1, Circle* c2, const PhysicsSettings& ps);
+	CircleCircleContact(const ContactManifold& m, const PhysicsSettings& ps);
 
 private:
 	void initPoints() override;
 	void rebuildPoint(ContactPoint& cp) override;
 	void updateNormal() override;
+	void setFeatures(const ContactManifold& m) override;
 
 	const Circle* const c1;
 	const Circle* const c2;
+
+	// Found by the narrow phase, and used for the initial contact point
+	vec2 initialNormal;
+	real initialPenetration = 0;
+	vec2 initialPoint;
 };
 
@@ -0,0 +1,26 @@
+#include "Collide.h"
+#include "ConvexPolygon.h"
+#include "Circle.h"
+
+// For two bodies of the same shape, the test is run on rb2. Near-ties in the choice
+// of reference polygon favour the one it's run on, so this keeps the choice consistent.
+
+bool collidePolygons(RigidBody* rb1, RigidBody* rb2, real margin, PairCache& cache, ContactManifold& manifold)
+{
+	return static_cast<ConvexPolygon*>(rb2)->checkCollision(static_cast<ConvexPolygon*>(rb1), margin, cache, manifold);
+}
+
+bool collidePolygonCircle(RigidBody* rb1, RigidBody* rb2, real margin, PairCache& cache, ContactManifold& manifold)
+{
+	return static_cast<ConvexPolygon*>(rb1)->checkCollision(static_cast<Circle*>(rb2), margin, cache, manifold);
+}
+
+bool collideCirclePolygon(RigidBody* rb1, RigidBody* rb2, real margin, PairCache& cache, ContactManifold& manifold)
+{
+	return static_cast<ConvexPolygon*>(rb2)->checkCollision(static_cast<Circle*>(rb1), margin, cache, manifold);
+}
+
+bool collideCircles(RigidBody* rb1, RigidBody* rb2, real margin, PairCache&, ContactManifold& manifold)
+{
+	return static_cast<Circle*>(rb2)->checkCollision(static_cast<Circle*>(rb1), margin, manifold);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "RigidBody.h"
+#include "PairCache.h"
+#include "ContactManifold.h"
+
+// Tests a pair of bodies, ordered so that rb1->id < rb2->id, for contact. Returns whether they
+// are in contact, or less than margin apart, and if so fills in manifold.
+// cache persists between calls for the same pair.
+using CollideFunction = bool (*)(RigidBody* rb1, RigidBody* rb2, real margin, PairCache& cache, ContactManifold& manifold);
+
+bool collidePolygons(RigidBody* rb1, RigidBody* rb2, real margin, PairCache& cache, ContactManifold& manifold);
+bool collidePolygonCircle(RigidBody* rb1, RigidBody* rb2, real margin, PairCache& cache, ContactManifold& manifold);
+bool collideCirclePolygon(RigidBody* rb1, RigidBody* rb2, real margin, PairCache& cache, ContactManifold& manifold);
+bool collideCircles(RigidBody* rb1, RigidBody* rb2, real margin, PairCache& cache, ContactManifold& manifold);
+
+// Index of the entry for a pair of shapes in the collide function table
+inline int shapePairIndex(Shape s1, Shape s2)
+{
+	return static_cast<int>(s1) * static_cast<int>(Shape::Count) + static_cast<int>(s2);
+}
+
+inline int shapePairIndex(const RigidBody* rb1, const RigidBody* rb2)
+{
+	return shapePairIndex(rb1->shape(), rb2->shape());
+}
+
+// Collide functions indexed by shapePairIndex(). A new shape needs a value in the Shape
+// enum and a function for each existing shape, in both orders.
+inline constexpr std::array<CollideFunction, static_cast<int>(Shape::Count) * static_cast<int>(Shape::Count)> collideTable =
+{
+	collidePolygons,      collidePolygonCircle,
+	collideCirclePolygon, collideCircles
+};
+
+inline bool collide(RigidBody* rb1, RigidBody* rb2, PairCache& cache, ContactManifold& manifold)
+{
+	return collideTable[shapePairIndex(rb1, rb2)](rb1, rb2, rb1->speculativeMargin(rb2), cache, manifold);
+}
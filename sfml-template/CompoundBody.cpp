@@ -0,0 +1,125 @@
+#include "CompoundBody.h"
+
+CompoundBody::CompoundBody(const PhysicsSettings& ps, const std::vector<RigidBody*>& children):
+	RigidBody(ps, Shape::Compound),
+	children(children)
+{
+	// Combined mass, centre of mass and momentum
+	bool fixedPosition = false;
+	real mass = 0;
+	vec2 centre, momentum;
+
+	for (RigidBody* c : children)
+	{
+		if (c->mInv() == 0)
+		{
+			fixedPosition = true;
+			continue;
+		}
+
+		real m = 1 / c->mInv();
+		mass += m;
+		centre += m * c->position();
+		momentum += m * c->velocity();
+	}
+
+	if (fixedPosition)
+	{
+		centre = {};
+
+		for (RigidBody* c : children)
+		{
+			centre += c->position();
+		}
+
+		centre /= static_cast<real>(children.size());
+	}
+	else
+	{
+		centre /= mass;
+	}
+
+	pos = posPrev = centre;
+
+	// Moment of inertia and angular momentum about the centre of mass
+	bool fixedRotation = fixedPosition;
+	real inertia = 0;
+	real angularMomentum = 0;
+
+	for (RigidBody* c : children)
+	{
+		if (c->IInv() == 0)
+		{
+			fixedRotation = true;
+		}
+		else
+		{
+			inertia += 1 / c->IInv();
+			angularMomentum += c->angVel() / c->IInv();
+		}
+
+		if (!fixedPosition)
+		{
+			vec2 r = c->position() - centre;
+			real m = 1 / c->mInv();
+
+			inertia += m * dot(r, r);
+			angularMomentum += m * zcross(r, c->velocity());
+		}
+	}
+
+	if (!fixedPosition)
+	{
+		setmInv(1 / mass);
+		vel = momentum / mass;
+	}
+
+	if (!fixedRotation)
+	{
+		setIInv(1 / inertia);
+		omega = angularMomentum / inertia;
+	}
+
+	// The children share the compound's mass, so that they are static exactly when it is
+	for (RigidBody* c : children)
+	{
+		c->owner = this;
+		c->compoundPos = pointToLocal(c->position());
+		c->compoundAngle = c->angle() - angle();
+
+		c->setmInv(mInv());
+		c->setIInv(IInv());
+	}
+
+	onMove();
+}
+
+bool CompoundBody::pointInside(const vec2& p) const
+{
+	return std::any_of(children.begin(), children.end(), [&](const RigidBody* c) { return c->pointInside(p); });
+}
+
+void CompoundBody::onMove()
+{
+	updateChildPoses();
+
+	for (RigidBody* c : children)
+	{
+		c->onMove();
+	}
+}
+
+void CompoundBody::updateChildPoses()
+{
+	for (RigidBody* c : children)
+	{
+		c->pos = pointToGlobal(c->compoundPos);
+		c->theta = wrap(angle() + c->compoundAngle);
+
+		c->posPrev = transform(c->compoundPos, prevPosition(), prevAngle());
+		c->thetaPrev = wrap(prevAngle() + c->compoundAngle);
+
+		c->vel = pointVel(c->pos);
+		c->omega = angVel();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include "RigidBody.h"
+
+// A rigid body made of several shapes. The shapes are ordinary bodies (e.g. ConvexPolygons and Circles),
+// each with its own broad phase proxy and contacts, but they keep a fixed pose relative to the compound.
+// Their contacts apply impulses to the compound, which has their combined mass and inertia.
+// The compound itself has no proxy and doesn't need any constraints to hold it together.
+class CompoundBody : public RigidBody
+{
+public:
+	// The compound is placed at the children's centre of mass, with zero angle, and takes over their
+	// momentum. If any child has infinite mass (or inertia), so does the compound.
+	CompoundBody(const PhysicsSettings& ps, const std::vector<RigidBody*>& children);
+
+	// The children draw themselves
+	void draw(sf::RenderWindow&, real, bool = false, sf::Text* = nullptr) override { }
+
+	// True if any child contains p. Picking normally finds a child through its proxy instead.
+	bool pointInside(const vec2& p) const override;
+
+	// The compound has no proxy, so its AABB is never used: each child keeps its own
+	void updateAABB() override { }
+
+	// Move the children along with the compound
+	void onMove() override;
+
+	const std::vector<RigidBody*>& getChildren() const { return children; }
+
+protected:
+	void updateChildPoses() override;
+
+private:
+	std::vector<RigidBody*> children;
+};
\ No newline at end of file
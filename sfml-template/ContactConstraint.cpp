@@ -1,7 +1,7 @@
 #include "ContactConstraint.h"
 
-ContactConstraint::ContactConstraint(const PhysicsSettings& ps, RigidBody* rb1, RigidBody* rb2):
-	ps(ps), rb1(rb1), rb2(rb2),
+ContactConstraint::ContactConstraint(const PhysicsSettings& ps, ContactType type, RigidBody* rb1, RigidBody* rb2):
+	ps(ps), mType(type), rb1(rb1), rb2(rb2), body1(rb1->body()), body2(rb2->body()),
 	e(ps.eDefault), mu(ps.muDefault), rfLength(ps.rfLengthDefault)
 {
 	// Sort by index of incident point to ensure a consistent ordering
@@ -13,8 +13,10 @@ ContactConstraint::ContactConstraint(const PhysicsSettings& ps, RigidBody* rb1,
 
 void ContactConstraint::init()
 {
+	contactPoints = {};
+	ncp = 0;
+
 	initPoints();
-	ncp = contactPoints.size();
 	storeTargetVelocities();
 }
 
@@ -22,13 +24,13 @@ void ContactConstraint::correctVel()
 {
 	if (rollingFriction)
 	{
-		for (auto& cp : contactPoints)
+		for (auto& cp : points())
 		{
 			solvePointRollFriction(cp);
 		}
 	}
 
-	for (auto& cp : contactPoints)
+	for (auto& cp : points())
 	{
 		solvePointFriction(cp);
 	}
@@ -44,7 +46,7 @@ void ContactConstraint::correctVel()
 
 	// At this point, simultaneous solution failed, either because the condition number was too high or 
 	// because one of the accumulated impulses would become negative. So, resort to the iterative solution.
-	for (auto& cp : contactPoints)
+	for (auto& cp : points())
 	{
 		solvePointVel(cp);
 	}
@@ -57,7 +59,7 @@ void ContactConstraint::correctPos()
 	{
 		updateNormal();
 
-		for (auto& cp : contactPoints)
+		for (auto& cp : points())
 		{
 			rebuildPoint(cp);
 			updateNormalFactors(cp);
@@ -73,7 +75,7 @@ void ContactConstraint::correctPos()
 	}
 
 	// At this point, the condition number was too high, so resort to the iterative solution.
-	for (auto& cp : contactPoints)
+	for (auto& cp : points())
 	{
 		updateNormal();
 		rebuildPoint(cp);
@@ -84,7 +86,7 @@ void ContactConstraint::correctPos()
 
 void ContactConstraint::warmStart()
 {
-	for (auto& cp : contactPoints)
+	for (auto& cp : points())
 	{
 		warmStartPoint(cp);
 	}
@@ -95,7 +97,7 @@ void ContactConstraint::prepareVelSolver()
 	updateNormal();
 	updateTangent();
 
-	for (auto& cp : contactPoints)
+	for (auto& cp : points())
 	{
 		updateNormalFactors(cp);
 		updateTangentFactors(cp);
@@ -107,22 +109,34 @@ void ContactConstraint::prepareVelSolver()
 	}
 }
 
-void ContactConstraint::getImpulsesFrom(ContactConstraint* other)
+bool ContactConstraint::matches(const ContactManifold& m) const
 {
-	if (!idsMatch(other))
-	{
-		return;
-	}
+	return m.type == mType && m.rb1 == rb1 && m.rb2 == rb2;
+}
+
+void ContactConstraint::refresh(const ContactManifold& m)
+{
+	std::array<ContactPoint, 2> oldPoints = contactPoints;
+	int oldNcp = ncp;
+
+	setFeatures(m);
+	init();
+	copyImpulsesFrom({ oldPoints.data(), static_cast<size_t>(oldNcp) });
+
+	remove = false;
+}
 
-	for (int i = 0; i < ncp; ++i)
+void ContactConstraint::copyImpulsesFrom(std::span<const ContactPoint> oldPoints)
+{
+	for (ContactPoint& cp : points())
 	{
-		for (int j = 0; j < other->ncp; ++j)
+		for (const ContactPoint& old : oldPoints)
 		{
-			if (contactPoints[i].matches(other->contactPoints[j]))
+			if (cp.matches(old))
 			{
-				contactPoints[i].lambda = other->contactPoints[j].lambda;
-				contactPoints[i].fLambda = other->contactPoints[j].fLambda;
-				contactPoints[i].fRollLambda = other->contactPoints[j].fRollLambda;
+				cp.lambda = old.lambda;
+				cp.fLambda = old.fLambda;
+				cp.fRollLambda = old.fRollLambda;
 				break;
 			}
 		}
@@ -134,7 +148,7 @@ void ContactConstraint::draw(sf::RenderWindow& window, real fraction, bool debug
 	real normalHalfLengthPix = 6;
 	real normalThickness = 2;
 
-	for (const auto& cp : contactPoints)
+	for (const auto& cp : points())
 	{
 		vec2 pos = { cp.point.x * ps.pixPerUnit, cp.point.y * ps.pixPerUnit };
 		drawThickLine(window, pos - normalHalfLengthPix * n, pos + normalHalfLengthPix * n, normalThickness, sf::Color::Black);
@@ -154,10 +168,10 @@ void ContactConstraint::draw(sf::RenderWindow& window, real fraction, bool debug
 
 void ContactConstraint::solvePointRollFriction(ContactPoint& cp)
 {
-	real vDotGradCfRoll = rb2->angVel() - rb1->angVel();
+	real vDotGradCfRoll = body2->angVel() - body1->angVel();
 
 	real dfRollLambda = 0;
-	real denom = rb1->IInv() + rb2->IInv();
+	real denom = body1->IInv() + body2->IInv();
 
 	if (denom != 0)
 	{
@@ -167,13 +181,13 @@ void ContactConstraint::solvePointRollFriction(ContactPoint& cp)
 
 	cp.fRollLambda += dfRollLambda;
 
-	rb1->applyDeltaVel({}, -rb1->IInv() * dfRollLambda);
-	rb2->applyDeltaVel({}, rb2->IInv() * dfRollLambda);
+	body1->applyDeltaVel({}, -body1->IInv() * dfRollLambda);
+	body2->applyDeltaVel({}, body2->IInv() * dfRollLambda);
 }
 
 void ContactConstraint::solvePointFriction(ContactPoint& cp)
 {
-	real vDotGradCf = dot(rb2->velocity() - rb1->velocity(), t) + cp.tCrossFactor2 * rb2->angVel() - cp.tCrossFactor1 * rb1->angVel();
+	real vDotGradCf = dot(body2->velocity() - body1->velocity(), t) + cp.tCrossFactor2 * body2->angVel() - cp.tCrossFactor1 * body1->angVel();
 
 	real dfLambda = 0;
 	if (cp.tMassFactor != 0)
@@ -184,13 +198,13 @@ void ContactConstraint::solvePointFriction(ContactPoint& cp)
 
 	cp.fLambda += dfLambda;
 
-	rb1->applyDeltaVel(-t * rb1->mInv() * dfLambda, -cp.tCrossFactor1 * rb1->IInv() * dfLambda);
-	rb2->applyDeltaVel(t * rb2->mInv() * dfLambda, cp.tCrossFactor2 * rb2->IInv() * dfLambda);
+	body1->applyDeltaVel(-t * body1->mInv() * dfLambda, -cp.tCrossFactor1 * body1->IInv() * dfLambda);
+	body2->applyDeltaVel(t * body2->mInv() * dfLambda, cp.tCrossFactor2 * body2->IInv() * dfLambda);
 }
 
 void ContactConstraint::solvePointVel(ContactPoint& cp)
 {
-	real vDotGradC = dot(rb2->velocity() - rb1->velocity(), n) + cp.nCrossFactor2 * rb2->angVel() - cp.nCrossFactor1 * rb1->angVel();
+	real vDotGradC = dot(body2->velocity() - body1->velocity(), n) + cp.nCrossFactor2 * body2->angVel() - cp.nCrossFactor1 * body1->angVel();
 	
 	real dLambda = 0;
 	if (cp.nMassFactor != 0)
@@ -201,8 +215,8 @@ void ContactConstraint::solvePointVel(ContactPoint& cp)
 
 	cp.lambda += dLambda;
 	
-	rb1->applyDeltaVel(-n * rb1->mInv() * dLambda, -cp.nCrossFactor1 * rb1->IInv() * dLambda);
-	rb2->applyDeltaVel(n * rb2->mInv() * dLambda, cp.nCrossFactor2 * rb2->IInv() * dLambda);
+	body1->applyDeltaVel(-n * body1->mInv() * dLambda, -cp.nCrossFactor1 * body1->IInv() * dLambda);
+	body2->applyDeltaVel(n * body2->mInv() * dLambda, cp.nCrossFactor2 * body2->IInv() * dLambda);
 }
 
 void ContactConstraint::solvePointPos(ContactPoint& cp)
@@ -220,8 +234,8 @@ void ContactConstraint::solvePointPos(ContactPoint& cp)
 	}
 
 	// Don't need to call the RigidBody update functions until after the iterations are complete
-	rb1->applyDeltaPos(-n * rb1->mInv() * dLambda, -cp.nCrossFactor1 * rb1->IInv() * dLambda, false);
-	rb2->applyDeltaPos(n * rb2->mInv() * dLambda, cp.nCrossFactor2 * rb2->IInv() * dLambda, false);
+	body1->applyDeltaPos(-n * body1->mInv() * dLambda, -cp.nCrossFactor1 * body1->IInv() * dLambda, false);
+	body2->applyDeltaPos(n * body2->mInv() * dLambda, cp.nCrossFactor2 * body2->IInv() * dLambda, false);
 }
 
 void ContactConstraint::warmStartPoint(ContactPoint& cp)
@@ -231,11 +245,11 @@ void ContactConstraint::warmStartPoint(ContactPoint& cp)
 		// Don't warm start rolling friction - this occasionally causes infinite spinning and should be investigated!
 		cp.fRollLambda = 0;
 
-		rb1->applyDeltaVel(-n * rb1->mInv() * cp.lambda - t * rb1->mInv() * cp.fLambda,
-			-cp.nCrossFactor1 * rb1->IInv() * cp.lambda - cp.tCrossFactor1 * rb1->IInv() * cp.fLambda - rb1->IInv() * cp.fRollLambda);
+		body1->applyDeltaVel(-n * body1->mInv() * cp.lambda - t * body1->mInv() * cp.fLambda,
+			-cp.nCrossFactor1 * body1->IInv() * cp.lambda - cp.tCrossFactor1 * body1->IInv() * cp.fLambda - body1->IInv() * cp.fRollLambda);
 
-		rb2->applyDeltaVel(n * rb2->mInv() * cp.lambda + t * rb2->mInv() * cp.fLambda,
-			cp.nCrossFactor2 * rb2->IInv() * cp.lambda + cp.tCrossFactor2 * rb2->IInv() * cp.fLambda + rb2->IInv() * cp.fRollLambda);
+		body2->applyDeltaVel(n * body2->mInv() * cp.lambda + t * body2->mInv() * cp.fLambda,
+			cp.nCrossFactor2 * body2->IInv() * cp.lambda + cp.tCrossFactor2 * body2->IInv() * cp.fLambda + body2->IInv() * cp.fRollLambda);
 	}
 	else
 	{
@@ -243,19 +257,24 @@ void ContactConstraint::warmStartPoint(ContactPoint& cp)
 	}
 }
 
-bool ContactConstraint::idsMatch(const ContactConstraint* other) const
-{
-	return rb1->id == other->rb1->id && rb2->id == other->rb2->id;
-}
-
 void ContactConstraint::storeTargetVelocities()
 {
 	updateNormal();
 
-	for (auto& cp : contactPoints)
+	for (auto& cp : points())
 	{
-		real vRel = dot(rb2->pointVel(cp.point) - rb1->pointVel(cp.point), n);
-		cp.vRelTarget = vRel < -ps.vRelThreshold ? -e * vRel : 0;
+		real vRel = dot(body2->pointVel(cp.point) - body1->pointVel(cp.point), n);
+
+		// Bounce only if the gap (if any) would close during this step. Otherwise, for a speculative
+		// point, allow the bodies to approach by up to the size of the gap.
+		if (vRel < -ps.vRelThreshold && vRel * ps.dt < -cp.penetration)
+		{
+			cp.vRelTarget = -e * vRel;
+		}
+		else
+		{
+			cp.vRelTarget = -std::max(cp.penetration, static_cast<real>(0)) / ps.dt;
+		}
 	}
 }
 
@@ -269,7 +288,7 @@ void ContactConstraint::prepareSimulSolver()
 	ContactPoint& cp1 = contactPoints[0];
 	ContactPoint& cp2 = contactPoints[1];
 
-	A12 = rb2->mInv() + rb1->mInv() + rb2->IInv() * cp1.nCrossFactor2 * cp2.nCrossFactor2 + rb1->IInv() * cp1.nCrossFactor1 * cp2.nCrossFactor1;
+	A12 = body2->mInv() + body1->mInv() + body2->IInv() * cp1.nCrossFactor2 * cp2.nCrossFactor2 + body1->IInv() * cp1.nCrossFactor1 * cp2.nCrossFactor1;
 	det = cp1.nMassFactor * cp2.nMassFactor - A12 * A12;
 	norm = std::max(cp1.nMassFactor, cp2.nMassFactor) + std::abs(A12);
 	real normSquared = norm * norm;
@@ -284,8 +303,8 @@ bool ContactConstraint::simulSolveVel()
 	ContactPoint& cp1 = contactPoints[0];
 	ContactPoint& cp2 = contactPoints[1];
 
-	real alpha1 = cp1.vRelTarget - (dot(rb2->velocity() - rb1->velocity(), n) + cp1.nCrossFactor2 * rb2->angVel() - cp1.nCrossFactor1 * rb1->angVel());
-	real alpha2 = cp2.vRelTarget - (dot(rb2->velocity() - rb1->velocity(), n) + cp2.nCrossFactor2 * rb2->angVel() - cp2.nCrossFactor1 * rb1->angVel());
+	real alpha1 = cp1.vRelTarget - (dot(body2->velocity() - body1->velocity(), n) + cp1.nCrossFactor2 * body2->angVel() - cp1.nCrossFactor1 * body1->angVel());
+	real alpha2 = cp2.vRelTarget - (dot(body2->velocity() - body1->velocity(), n) + cp2.nCrossFactor2 * body2->angVel() - cp2.nCrossFactor1 * body1->angVel());
 	
 
 	// First assume both accumulated impulses are non-negative
@@ -294,8 +313,8 @@ bool ContactConstraint::simulSolveVel()
 
 	if (cp1.lambda + lam1 >= 0 && cp2.lambda + lam2 >= 0)
 	{
-		rb1->applyDeltaVel(-n * rb1->mInv() * (lam1 + lam2), rb1->IInv() * (-cp1.nCrossFactor1 * lam1 - cp2.nCrossFactor1 * lam2));
-		rb2->applyDeltaVel(n * rb2->mInv() * (lam1 + lam2), rb2->IInv() * (cp1.nCrossFactor2 * lam1 + cp2.nCrossFactor2 * lam2));
+		body1->applyDeltaVel(-n * body1->mInv() * (lam1 + lam2), body1->IInv() * (-cp1.nCrossFactor1 * lam1 - cp2.nCrossFactor1 * lam2));
+		body2->applyDeltaVel(n * body2->mInv() * (lam1 + lam2), body2->IInv() * (cp1.nCrossFactor2 * lam1 + cp2.nCrossFactor2 * lam2));
 
 		cp1.lambda += lam1;
 		cp2.lambda += lam2;
@@ -310,8 +329,8 @@ bool ContactConstraint::simulSolveVel()
 
 	if (lam1 * cp1.nMassFactor + lam2 * A12 >= alpha1 && lam1 * A12 + lam2 * cp2.nMassFactor >= alpha2)
 	{
-		rb1->applyDeltaVel(-n * rb1->mInv() * (lam1 + lam2), rb1->IInv() * (-cp1.nCrossFactor1 * lam1 - cp2.nCrossFactor1 * lam2));
-		rb2->applyDeltaVel(n * rb2->mInv() * (lam1 + lam2), rb2->IInv() * (cp1.nCrossFactor2 * lam1 + cp2.nCrossFactor2 * lam2));
+		body1->applyDeltaVel(-n * body1->mInv() * (lam1 + lam2), body1->IInv() * (-cp1.nCrossFactor1 * lam1 - cp2.nCrossFactor1 * lam2));
+		body2->applyDeltaVel(n * body2->mInv() * (lam1 + lam2), body2->IInv() * (cp1.nCrossFactor2 * lam1 + cp2.nCrossFactor2 * lam2));
 
 		cp1.lambda += lam1;
 		cp2.lambda += lam2;
@@ -325,8 +344,8 @@ bool ContactConstraint::simulSolveVel()
 
 	if (cp2.lambda + lam2 >= 0 && lam1 * cp1.nMassFactor + lam2 * A12 >= alpha1)
 	{
-		rb1->applyDeltaVel(-n * rb1->mInv() * (lam1 + lam2), rb1->IInv() * (-cp1.nCrossFactor1 * lam1 - cp2.nCrossFactor1 * lam2));
-		rb2->applyDeltaVel(n * rb2->mInv() * (lam1 + lam2), rb2->IInv() * (cp1.nCrossFactor2 * lam1 + cp2.nCrossFactor2 * lam2));
+		body1->applyDeltaVel(-n * body1->mInv() * (lam1 + lam2), body1->IInv() * (-cp1.nCrossFactor1 * lam1 - cp2.nCrossFactor1 * lam2));
+		body2->applyDeltaVel(n * body2->mInv() * (lam1 + lam2), body2->IInv() * (cp1.nCrossFactor2 * lam1 + cp2.nCrossFactor2 * lam2));
 
 		cp1.lambda += lam1;
 		cp2.lambda += lam2;
@@ -340,8 +359,8 @@ bool ContactConstraint::simulSolveVel()
 
 	if (cp1.lambda + lam1 >= 0 && lam2 * cp2.nMassFactor + lam1 * A12 >= alpha2)
 	{
-		rb1->applyDeltaVel(-n * rb1->mInv() * (lam1 + lam2), rb1->IInv() * (-cp1.nCrossFactor1 * lam1 - cp2.nCrossFactor1 * lam2));
-		rb2->applyDeltaVel(n * rb2->mInv() * (lam1 + lam2), rb2->IInv() * (cp1.nCrossFactor2 * lam1 + cp2.nCrossFactor2 * lam2));
+		body1->applyDeltaVel(-n * body1->mInv() * (lam1 + lam2), body1->IInv() * (-cp1.nCrossFactor1 * lam1 - cp2.nCrossFactor1 * lam2));
+		body2->applyDeltaVel(n * body2->mInv() * (lam1 + lam2), body2->IInv() * (cp1.nCrossFactor2 * lam1 + cp2.nCrossFactor2 * lam2));
 
 		cp1.lambda += lam1;
 		cp2.lambda += lam2;
@@ -368,26 +387,26 @@ void ContactConstraint::simulSolvePos()
 	real lam2 = (cp1.nMassFactor * alpha2 - A12 * alpha1) / det;
 
 	// Don't need to call the RigidBody update functions until after the iterations are complete
-	rb1->applyDeltaPos(-n * rb1->mInv() * (lam1 + lam2), rb1->IInv() * (-cp1.nCrossFactor1 * lam1 - cp2.nCrossFactor1 * lam2), false);
-	rb2->applyDeltaPos(n * rb2->mInv() * (lam1 + lam2), rb2->IInv() * (cp1.nCrossFactor2 * lam1 + cp2.nCrossFactor2 * lam2), false);
+	body1->applyDeltaPos(-n * body1->mInv() * (lam1 + lam2), body1->IInv() * (-cp1.nCrossFactor1 * lam1 - cp2.nCrossFactor1 * lam2), false);
+	body2->applyDeltaPos(n * body2->mInv() * (lam1 + lam2), body2->IInv() * (cp1.nCrossFactor2 * lam1 + cp2.nCrossFactor2 * lam2), false);
 }
 
 void ContactConstraint::updateNormalFactors(ContactPoint& cp)
 {
-	vec2 relPos1 = cp.point - rb1->position();
-	vec2 relPos2 = cp.point - rb2->position();
+	vec2 relPos1 = cp.point - body1->position();
+	vec2 relPos2 = cp.point - body2->position();
 
 	cp.nCrossFactor1 = zcross(relPos1, n);
 	cp.nCrossFactor2 = zcross(relPos2, n);
-	cp.nMassFactor = rb1->mInv() + rb2->mInv() + rb1->IInv() * std::pow(cp.nCrossFactor1, 2) + rb2->IInv() * std::pow(cp.nCrossFactor2, 2);
+	cp.nMassFactor = body1->mInv() + body2->mInv() + body1->IInv() * std::pow(cp.nCrossFactor1, 2) + body2->IInv() * std::pow(cp.nCrossFactor2, 2);
 }
 
 void ContactConstraint::updateTangentFactors(ContactPoint& cp)
 {
-	vec2 relPos1 = cp.point - rb1->position();
-	vec2 relPos2 = cp.point - rb2->position();
+	vec2 relPos1 = cp.point - body1->position();
+	vec2 relPos2 = cp.point - body2->position();
 
 	cp.tCrossFactor1 = zcross(relPos1, t);
 	cp.tCrossFactor2 = zcross(relPos2, t);
-	cp.tMassFactor = rb1->mInv() + rb2->mInv() + rb1->IInv() * std::pow(cp.tCrossFactor1, 2) + rb2->IInv() * std::pow(cp.tCrossFactor2, 2);
+	cp.tMassFactor = body1->mInv() + body2->mInv() + body1->IInv() * std::pow(cp.tCrossFactor1, 2) + body2->IInv() * std::pow(cp.tCrossFactor2, 2);
 }
@@ -4,6 +4,8 @@
 #include "RigidBody.h"
 #include "PhysicsSettings.h"
 #include "ContactPoint.h"
+#include "ContactManifold.h"
+#include <span>
 
 class PolyPolyContact;
 class CircleCircleContact;
@@ -13,21 +15,27 @@ class RigidBody;
 class ContactConstraint
 {
 public:
-	ContactConstraint(const PhysicsSettings& ps, RigidBody* rb1, RigidBody* rb2);
+	ContactConstraint(const PhysicsSettings& ps, ContactType type, RigidBody* rb1, RigidBody* rb2);
 
 	void init();
 	void correctVel();
 	void correctPos();
 	void warmStart();
 	void prepareVelSolver();
-	void getImpulsesFrom(ContactConstraint* other);
+
+	ContactType type() const { return mType; }
+
+	// Whether m describes a contact of the same type between the same bodies, in the same order
+	bool matches(const ContactManifold& m) const;
+
+	// Rebuild the contact points in place from the new features in m, which must match this
+	// constraint, carrying over the impulses of any points that persist
+	void refresh(const ContactManifold& m);
 
 	void markForRemoval() { remove = true; }
 	bool removeFlagSet() const { return remove; }
 
 	void draw(sf::RenderWindow& window, real fraction, bool debug = false, sf::Text* text = nullptr);
-	
-	int numPersist = 0;
 
 protected:
 	// The details of the below functions depend on the specific types of rigid body involved
@@ -35,11 +43,17 @@ protected:
 	virtual void updateNormal() = 0;
 	virtual void rebuildPoint(ContactPoint& cp) = 0;
 
+	// Copy any type-specific features from a matching manifold
+	virtual void setFeatures(const ContactManifold& m) = 0;
+
 	void enableRollingFriction() { rollingFriction = true; }
 	void disableRollingFriction() { rollingFriction = false; }
-	bool idsMatch(const ContactConstraint* other) const;
 
-	std::vector<ContactPoint> contactPoints;
+	// Contact points are stored inline, and only the first ncp are in use
+	std::span<ContactPoint> points() { return { contactPoints.data(), static_cast<size_t>(ncp) }; }
+	ContactPoint& addPoint() { return contactPoints[ncp++]; }
+
+	std::array<ContactPoint, 2> contactPoints;
 	int ncp = 0;
 
 	// Collision normal & tangent (shared by all contact points)
@@ -64,8 +78,16 @@ private:
 	void solvePointPos(ContactPoint& cp);
 	void warmStartPoint(ContactPoint& cp);
 
+	void copyImpulsesFrom(std::span<const ContactPoint> oldPoints);
+
+	const ContactType mType;
+
+	// The shapes in contact, and the bodies that the impulses are applied to. These differ for
+	// shapes that are part of a compound body.
 	RigidBody* const rb1;
 	RigidBody* const rb2;
+	RigidBody* const body1;
+	RigidBody* const body2;
 
 	real mu = 0;
 	real e = 0;
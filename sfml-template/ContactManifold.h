@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Utils.h"
+
+class RigidBody;
+
+enum class ContactType : uint8_t { PolyPoly, PolyCircle, CircleCircle };
+
+// Output of a narrow phase test, from which a contact constraint is built or updated.
+// rb1 and rb2 are in the order expected by the constraint type, e.g. reference body first.
+struct ContactManifold
+{
+	ContactType type = ContactType::CircleCircle;
+	RigidBody* rb1 = nullptr;
+	RigidBody* rb2 = nullptr;
+
+	// Poly-poly: reference edge on rb1 and incident edge on rb2, and the separation
+	// up to which clipped points are kept as speculative contact points
+	int refEdge = 0;
+	int incEdge = 0;
+	real margin = 0;
+
+	// Poly-circle: normal and reference point in the polygon's local coordinates,
+	// and the region of the polygon closest to the circle
+	vec2 localNormal;
+	vec2 localRefPoint;
+	Voronoi region = Voronoi::Inside;
+
+	// Circle-circle: unit normal from rb1 to rb2 (zero if the centres coincide),
+	// and the penetration and contact point in the middle of the colliding region
+	vec2 normal;
+	real penetration = 0;
+	vec2 point;
+};
@@ -0,0 +1,38 @@
+#include "ContactPool.h"
+
+ContactConstraint* ContactPool::create(const ContactManifold& m)
+{
+	ContactConstraint* contact = nullptr;
+
+	switch (m.type)
+	{
+	case ContactType::PolyPoly:
+		contact = polyPoly.create(m, ps);
+		break;
+	case ContactType::PolyCircle:
+		contact = polyCircle.create(m, ps);
+		break;
+	case ContactType::CircleCircle:
+		contact = circleCircle.create(m, ps);
+		break;
+	}
+
+	contact->init();
+	return contact;
+}
+
+void ContactPool::destroy(ContactConstraint* contact)
+{
+	switch (contact->type())
+	{
+	case ContactType::PolyPoly:
+		polyPoly.destroy(static_cast<PolyPolyContact*>(contact));
+		break;
+	case ContactType::PolyCircle:
+		polyCircle.destroy(static_cast<PolyCircleContact*>(contact));
+		break;
+	case ContactType::CircleCircle:
+		circleCircle.destroy(static_cast<CircleCircleContact*>(contact));
+		break;
+	}
+}
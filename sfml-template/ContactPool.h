@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ContactConstraint.h"
+#include "PolyPolyContact.h"
+#include "PolyCircleContact.h"
+#include "CircleCircleContact.h"
+#include <deque>
+
+// Owns every contact constraint. Each type has its own storage, and the slots of destroyed
+// constraints are reused, so once a scene has settled no further allocations are needed.
+class ContactPool
+{
+public:
+	ContactPool(const PhysicsSettings& ps) : ps(ps) {}
+
+	ContactPool(const ContactPool&) = delete;
+	ContactPool& operator=(const ContactPool&) = delete;
+
+	// Build a new constraint from m, with its contact points initialised
+	ContactConstraint* create(const ContactManifold& m);
+	void destroy(ContactConstraint* contact);
+
+private:
+	template <typename T>
+	class Slots
+	{
+	public:
+		template <typename... Args>
+		T* create(Args&&... args);
+		void destroy(T* obj);
+
+	private:
+		struct alignas(T) Slot
+		{
+			std::byte storage[sizeof(T)];
+		};
+
+		// A deque never moves its elements when it grows
+		std::deque<Slot> slots;
+		std::vector<Slot*> freeSlots;
+	};
+
+	const PhysicsSettings& ps;
+
+	Slots<PolyPolyContact> polyPoly;
+	Slots<PolyCircleContact> polyCircle;
+	Slots<CircleCircleContact> circleCircle;
+};
+
+template <typename T>
+template <typename... Args>
+T* ContactPool::Slots<T>::create(Args&&... args)
+{
+	static_assert(std::is_trivially_destructible_v<T>, "Live objects are not destroyed along with the pool");
+
+	if (freeSlots.empty())
+	{
+		freeSlots.push_back(&slots.emplace_back());
+	}
+
+	Slot* slot = freeSlots.back();
+	freeSlots.pop_back();
+
+	return new (slot->storage) T(std::forward<Args>(args)...);
+}
+
+template <typename T>
+void ContactPool::Slots<T>::destroy(T* obj)
+{
+	obj->~T();
+	freeSlots.push_back(reinterpret_cast<Slot*>(obj));
+}
@@ -3,23 +3,16 @@
 
 ConvexPolygon::ConvexPolygon(const PhysicsSettings& ps, int npoints, real sideLength, real mInv):
 	npoints(npoints),
-	RigidBody(ps, mInv)
+	RigidBody(ps, Shape::Polygon, mInv)
 {
-	createRegularPolygon(sideLength);
-
-	initialise();
+	initialise(regularPolygon(sideLength));
 }
 
 ConvexPolygon::ConvexPolygon(const PhysicsSettings& ps, const std::vector<vec2>& points, real mInv):
 	npoints(points.size()),
-	RigidBody(ps, mInv)
+	RigidBody(ps, Shape::Polygon, mInv)
 {
-	for (int i = 0; i < npoints; ++i)
-	{
-		vertices.emplace_back(std::make_unique<Vertex>(i, points[i], *this));
-	}
-
-	initialise();
+	initialise(points);
 }
 
 void ConvexPolygon::draw(sf::RenderWindow& window, real fraction, bool debug, sf::Text* text)
@@ -29,7 +22,7 @@ void ConvexPolygon::draw(sf::RenderWindow& window, real fraction, bool debug, sf
 
 	for (int i = 0; i < npoints; ++i)
 	{
-		vec2 v = vertices[i]->global(ipos, itheta) * ps.pixPerUnit;
+		vec2 v = transform(get(LocalVertex, i), ipos, itheta) * ps.pixPerUnit;
 		sf::Vector2f pointCoord(v.x, v.y); 
 
 		shape.setPoint(i, pointCoord);
@@ -54,35 +47,67 @@ void ConvexPolygon::draw(sf::RenderWindow& window, real fraction, bool debug, sf
 	circle.setFillColor(sf::Color::Magenta);
 }
 
-std::unique_ptr<ContactConstraint> ConvexPolygon::checkCollision(ConvexPolygon* other)
+bool ConvexPolygon::checkCollision(ConvexPolygon* other, real margin, PairCache& cache, ContactManifold& manifold)
 {
 	// Quickly rule out collisions using an AABB test
-	if (!aabb.overlaps(other->aabb))
+	if (!aabb.enlarged({ margin, margin }).overlaps(other->aabb))
 	{
-		return nullptr;
+		return false;
+	}
+
+	// The separating axis test is done on the cores, which can be further apart by the two skins
+	real coreMargin = margin + skin + other->skin;
+
+	// Test the axis found last time first. Pairs usually stay separated along the same axis
+	// for many steps, and a penetration greater than margin along any edge normal rules out a contact.
+	if (cache.axisOwner)
+	{
+		ConvexPolygon* owner = cache.axisOwner == this ? this : other;
+		ConvexPolygon* target = owner == this ? other : this;
+
+		if (owner->normalPenetration(cache.axisEdge, *target, 0).first > coreMargin)
+		{
+			cache.separated = true;
+			return false;
+		}
+
+		if (!cache.separated && owner->cachedFeaturesValid(*target, cache))
+		{
+			setPolyPolyManifold(manifold, owner, target, cache.axisEdge, cache.incidentEdge, margin);
+			return true;
+		}
 	}
 
 	// Check normal directions of *this
-	auto [earlyOutA, penetrationBtoA, edgeA, vertexB] = this->maxSignedPenetration(*other);
+	auto [earlyOutA, penetrationBtoA, edgeA, vertexB] = this->maxSignedPenetration(*other, coreMargin);
 
 	if (earlyOutA)
 	{
-		return nullptr;
+		// Clear the fields that only apply to touching pairs
+		cache = PairCache{};
+		cache.axisOwner = this;
+		cache.axisEdge = edgeA;
+		cache.separated = true;
+		return false;
 	}
 
 	// Check normal directions of *other
-	auto [earlyOutB, penetrationAtoB, edgeB, vertexA] = other->maxSignedPenetration(*this);
+	auto [earlyOutB, penetrationAtoB, edgeB, vertexA] = other->maxSignedPenetration(*this, coreMargin);
 
 	if (earlyOutB)
 	{
-		return nullptr;
+		cache = PairCache{};
+		cache.axisOwner = other;
+		cache.axisEdge = edgeB;
+		cache.separated = true;
+		return false;
 	}
 	
 	ConvexPolygon* ref = nullptr;
 	ConvexPolygon* inc = nullptr;
-	const Edge* refEdge = nullptr;
-	const Edge* incEdge = nullptr;
-	const Vertex* incVertex = nullptr;
+	int refEdge = 0;
+	int incEdge = 0;
+	int incVertex = 0;
 	
 	// TODO: could include both relative & absolute tolerance here?
 	if (penetrationBtoA > penetrationAtoB + ps.refEdgeAbsTol)
@@ -104,34 +129,43 @@ std::unique_ptr<ContactConstraint> ConvexPolygon::checkCollision(ConvexPolygon*
 		incVertex = vertexA;
 	}
 
-	// The deepest point has index incPointIndex, which is part of both the edge with index incPointIndex
+	// The deepest point has index incVertex, which is part of both the edge with index incVertex
 	// and the previous edge. The incident edge is least well-aligned with the reference normal.
-	vec2 normal = refEdge->normal();
+	vec2 normal = ref->normal(refEdge);
 	
-	if (inc->absEdgeDot(incVertex->e1(), normal) < inc->absEdgeDot(incVertex->e2(), normal))
+	if (inc->absEdgeDot(inc->prevIndex(incVertex), normal) < inc->absEdgeDot(incVertex, normal))
 	{
-		incEdge = incVertex->e1();
+		incEdge = inc->prevIndex(incVertex);
 	}
 	else
 	{
-		incEdge = incVertex->e2();
+		incEdge = incVertex;
 	}
+
+	auto [relPosition, relAngle] = ref->relativePose(*inc);
+	cache = PairCache{};
+	cache.axisOwner = ref;
+	cache.axisEdge = refEdge;
+	cache.incidentEdge = incEdge;
+	cache.relPosition = relPosition;
+	cache.relAngle = relAngle;
 	
-	return std::make_unique<PolyPolyContact>(ref, inc, refEdge, incEdge, ps);
+	setPolyPolyManifold(manifold, ref, inc, refEdge, incEdge, margin);
+	return true;
 }
 
-std::unique_ptr<ContactConstraint> ConvexPolygon::checkCollision(Circle* other)
+bool ConvexPolygon::checkCollision(Circle* other, real margin, PairCache& cache, ContactManifold& manifold)
 {
 	// Quickly rule out collisions using an AABB test
-	if (!aabb.overlaps(other->getAABB()))
+	if (!aabb.enlarged({ margin, margin }).overlaps(other->getAABB()))
 	{
-		return nullptr;
+		return false;
 	}
 
 	vec2 centre = other->position();
 	real rad = other->radius();
 
-	auto [closest, region] = closestPoint(centre);
+	auto [closest, region] = closestPoint(centre, cache);
 	
 	if (region == Voronoi::Inside)
 	{
@@ -140,14 +174,14 @@ std::unique_ptr<ContactConstraint> ConvexPolygon::checkCollision(Circle* other)
 		real maxSignedDistance = std::numeric_limits<real>::lowest();
 		vec2 projection, n;
 
-		for (auto& e : edges)
+		for (int i = 0; i < npoints; ++i)
 		{
-			real signedDistance = dot(closest - e->point1(), e->normal());
+			real signedDistance = dot(closest - vertex(i), normal(i));
 
 			if (signedDistance > maxSignedDistance)
 			{
 				maxSignedDistance = signedDistance;
-				n = e->normal();
+				n = normal(i);
 				projection = closest - signedDistance * n;
 			}
 		}
@@ -155,13 +189,14 @@ std::unique_ptr<ContactConstraint> ConvexPolygon::checkCollision(Circle* other)
 		vec2 localNormal = vecToLocal(n);
 		vec2 localClosest = pointToLocal(projection);
 
-		return std::make_unique<PolyCircleContact>(this, other, localNormal, localClosest, region, ps);
+		setPolyCircleManifold(manifold, other, localNormal, localClosest, region);
+		return true;
 	}
 	else
 	{
-		if (magnitude(centre - closest) < rad)
+		if (magnitude(centre - closest) < rad + skin + margin)
 		{
-			// Shallow contact
+			// Shallow or speculative contact
 			// Normal points from polygon to circle
 			vec2 localClosest = pointToLocal(closest);
 			
@@ -179,38 +214,51 @@ std::unique_ptr<ContactConstraint> ConvexPolygon::checkCollision(Circle* other)
 				localNormal = vecToLocal(n);
 			}
 
-			return std::make_unique<PolyCircleContact>(this, other, localNormal, localClosest, region, ps);
+			setPolyCircleManifold(manifold, other, localNormal, localClosest, region);
+			return true;
 		}
 		else
 		{
 			// No contact
-			return nullptr;
+			return false;
 		}
 	}
 }
 
-void ConvexPolygon::updateAABB()
+void ConvexPolygon::setPolyPolyManifold(ContactManifold& manifold, ConvexPolygon* ref, ConvexPolygon* inc, int refEdge, int incEdge, real margin)
 {
-	std::tie(aabb.lower.x, aabb.upper.x) = shadow({ 1, 0 });
-	std::tie(aabb.lower.y, aabb.upper.y) = shadow({ 0, 1 });
+	manifold.type = ContactType::PolyPoly;
+	manifold.rb1 = ref;
+	manifold.rb2 = inc;
+	manifold.refEdge = refEdge;
+	manifold.incEdge = incEdge;
+	manifold.margin = margin;
 }
 
-void ConvexPolygon::updateFatAABB()
+void ConvexPolygon::setPolyCircleManifold(ContactManifold& manifold, Circle* circle, const vec2& localNormal, const vec2& localRefPoint, Voronoi region)
 {
-	std::tie(aabbFat.lower.x, aabbFat.upper.x) = shadow({ 1, 0 });
-	std::tie(aabbFat.lower.y, aabbFat.upper.y) = shadow({ 0, 1 });
+	manifold.type = ContactType::PolyCircle;
+	manifold.rb1 = this;
+	manifold.rb2 = circle;
+	manifold.localNormal = localNormal;
+	manifold.localRefPoint = localRefPoint;
+	manifold.region = region;
+}
 
-	aabbFat.lower.x -= ps.aabbFattening;
-	aabbFat.lower.y -= ps.aabbFattening;
-	aabbFat.upper.x += ps.aabbFattening;
-	aabbFat.upper.y += ps.aabbFattening;
+void ConvexPolygon::updateAABB()
+{
+	std::tie(aabb.lower.x, aabb.upper.x) = shadow({ 1, 0 }, aabbSupport[0], aabbSupport[1]);
+	std::tie(aabb.lower.y, aabb.upper.y) = shadow({ 0, 1 }, aabbSupport[2], aabbSupport[3]);
+
+	aabb = aabb.enlarged({ skin, skin });
 }
 
 bool ConvexPolygon::pointInside(const vec2& p) const
 {
-	for (auto& e : edges)
+	// Treats the skin as having sharp corners
+	for (int i = 0; i < npoints; ++i)
 	{
-		if (dot(p - e->point1(), e->normal()) > 0)
+		if (dot(p - vertex(i), normal(i)) > skin)
 		{
 			return false;
 		}
@@ -225,9 +273,9 @@ void ConvexPolygon::centreOnCOM()
 
 	vec2 cm = calculateCOM();
 
-	for (auto& v : vertices)
+	for (int i = 0; i < npoints; ++i)
 	{
-		v->changeLocal(v->local() - cm, *this);
+		set(LocalVertex, i, get(LocalVertex, i) - cm);
 	}
 
 	// Coordinates of the original origin in the new coordinate system
@@ -236,15 +284,15 @@ void ConvexPolygon::centreOnCOM()
 
 vec2 ConvexPolygon::calculateCOM() const
 {
-	vec2 ref = vertices.front()->local();
+	vec2 ref = get(LocalVertex, 0);
 
 	real area = 0;
 	vec2 numerator;
 
 	for (int i = 1; i < npoints - 1; ++i)
 	{
-		vec2 u = vertices[i]->local() - ref;
-		vec2 v = vertices[i + 1]->local() - ref;
+		vec2 u = get(LocalVertex, i) - ref;
+		vec2 v = get(LocalVertex, i + 1) - ref;
 
 		real dA = 0.5 * std::abs(zcross(u, v));
 		vec2 dCM = (u + v) * static_cast<real>(1. / 3.);
@@ -269,8 +317,8 @@ real ConvexPolygon::calculateInvMOI() const
 
 	for (int i = 0; i < npoints ; ++i)
 	{
-		vec2 u = vertices[i]->local();
-		vec2 v = vertices[nextIndex(i)]->local();
+		vec2 u = get(LocalVertex, i);
+		vec2 v = get(LocalVertex, nextIndex(i));
 
 		real crossFactor = std::abs(zcross(u, v));
 		real dotFactor = dot(u, u) + dot(u, v) + dot(v, v);
@@ -290,48 +338,61 @@ real ConvexPolygon::calculateInvMOI() const
 void ConvexPolygon::onMove()
 {
 	real c = std::cos(angle()), s = std::sin(angle());
+	vec2 p = position();
+
+	// Rotate the vertices and normals and translate the vertices in a single pass
+	// over contiguous arrays, which the compiler can vectorise
+	const real* lx = xs(LocalVertex);
+	const real* ly = ys(LocalVertex);
+	const real* lnx = xs(LocalNormal);
+	const real* lny = ys(LocalNormal);
+	real* gx = xs(GlobalVertex);
+	real* gy = ys(GlobalVertex);
+	real* gnx = xs(GlobalNormal);
+	real* gny = ys(GlobalNormal);
 
-	std::for_each(std::execution::unseq, vertices.begin(), vertices.end(), [&](const std::unique_ptr<Vertex>& v)
-	{
-		v->recompute(position(), c, s);
-	});
-
-	std::for_each(std::execution::unseq, edges.begin(), edges.end(), [&](const std::unique_ptr<Edge>& e)
+	for (int i = 0; i < npoints; ++i)
 	{
-		e->recompute(c, s);
-	});
+		gx[i] = p.x + (c * lx[i] - s * ly[i]);
+		gy[i] = p.y + (s * lx[i] + c * ly[i]);
+		gnx[i] = c * lnx[i] - s * lny[i];
+		gny[i] = s * lnx[i] + c * lny[i];
+	}
 }
 
 
 // Returns <signed penetration, deepest vertex> 
-std::pair<real, const Vertex*> ConvexPolygon::normalPenetration(const Edge* e, const ConvexPolygon& other) const
+std::pair<real, int> ConvexPolygon::normalPenetration(int e, const ConvexPolygon& other, int hint) const
 {
-	vec2 normal = e->normal();
+	vec2 n = normal(e);
 
-	const Vertex* supportPointOther = other.supportVertex(-normal);
-	real signedDistance = dot(supportPointOther->global() - e->point1(), normal);
+	int supportPointOther = other.supportVertex(-n, hint);
+	real signedDistance = dot(other.vertex(supportPointOther) - vertex(e), n);
 
 	return {signedDistance, supportPointOther};
 }
 
 // Returns <early out, max signed penetration, edge of max signed penetration, penetrating vertex> 
 // If the first return value is true, should discard the others
-std::tuple<bool, real, const Edge*, const Vertex*> ConvexPolygon::maxSignedPenetration(const ConvexPolygon& other) const
+std::tuple<bool, real, int, int> ConvexPolygon::maxSignedPenetration(const ConvexPolygon& other, real margin) const
 {
 	bool earlyOut = false;
 	real maxPenetration = std::numeric_limits<real>::lowest();
 
-	const Edge* edge = nullptr;
-	const Vertex* vertex = nullptr;
+	int edge = 0;
+	int vertex = 0;
+	int hint = 0;
 
-	for (auto& e : edges)
+	for (int e = 0; e < npoints; ++e)
 	{
-		auto [penetration, v] = normalPenetration(e.get(), other);
+		// Successive edge normals rotate steadily, so start from the previous deepest vertex
+		auto [penetration, v] = normalPenetration(e, other, hint);
+		hint = v;
 
-		if (penetration > 0)
+		if (penetration > margin)
 		{
 			earlyOut = true;
-			edge = e.get();
+			edge = e;
 			break;
 		}
 
@@ -339,40 +400,41 @@ std::tuple<bool, real, const Edge*, const Vertex*> ConvexPolygon::maxSignedPenet
 		{
 			maxPenetration = penetration;
 			vertex = v;
-			edge = e.get();
+			edge = e;
 		}
 	}
 
 	return { earlyOut, maxPenetration, edge, vertex };
 }
 
-real ConvexPolygon::absEdgeDot(const Edge* e, const vec2& d) const
+real ConvexPolygon::absEdgeDot(int e, const vec2& d) const
 {
-	return std::abs(dot(e->global(), d));
+	return std::abs(dot(edge(e), d));
 }
 
-std::pair<real, real> ConvexPolygon::shadow(const vec2& n)
+std::pair<vec2, real> ConvexPolygon::relativePose(const ConvexPolygon& other) const
 {
-	// Assumes n is normalised
+	return { pointToLocal(other.position()), other.angle() - angle() };
+}
 
-	real smallest = std::numeric_limits<real>::max();
-	real largest = std::numeric_limits<real>::lowest();
-	
-	for (const auto& v : vertices)
-	{
-		real p = dot(v->global(), n);
+bool ConvexPolygon::cachedFeaturesValid(const ConvexPolygon& inc, const PairCache& cache) const
+{
+	auto [relPosition, relAngle] = relativePose(inc);
 
-		if (p > largest)
-		{
-			largest = p;
-		}
-		if (p < smallest)
-		{
-			smallest = p;
-		}
-	}
+	return magnitude(relPosition - cache.relPosition) < ps.satCacheLinearTol
+		&& std::abs(relAngle - cache.relAngle) < ps.satCacheAngularTol;
+}
+
+std::pair<real, real> ConvexPolygon::shadow(const vec2& n, int& lowest, int& highest) const
+{
+	// Assumes n is normalised
+
+	// The support vertices only change when the polygon rotates far enough,
+	// so climbing from the previous ones usually takes no steps at all
+	lowest = supportVertex(-n, lowest);
+	highest = supportVertex(n, highest);
 
-	return { smallest, largest };
+	return { dot(vertex(lowest), n), dot(vertex(highest), n) };
 }
 
 int ConvexPolygon::nextIndex(int i) const
@@ -386,13 +448,39 @@ int ConvexPolygon::prevIndex(int i) const
 }
 
 // Returns <closest point, region type>
-std::pair<vec2, Voronoi> ConvexPolygon::closestPoint(const vec2& point)
+std::pair<vec2, Voronoi> ConvexPolygon::closestPoint(const vec2& point, PairCache& cache)
 {
-	// NOTE: perhaps worth caching the previous result?
 	int nIter = 0;
 	
+	// Bodies move little between steps, so last step's simplex is usually already the
+	// right one, and GJK then finishes after a single support query
 	Simplex s;
-	s.addVertex(vertices[0].get());
+	int support = 0;
+
+	if (cache.simplexSize > 0)
+	{
+		for (int i = 0; i < cache.simplexSize; ++i)
+		{
+			s.addVertex(cache.simplexVertices[i], vertex(cache.simplexVertices[i]));
+		}
+
+		support = cache.simplexVertices[0];
+	}
+	else
+	{
+		s.addVertex(support, vertex(support));
+	}
+
+	auto finish = [&](const vec2& closest, Voronoi region) -> std::pair<vec2, Voronoi>
+	{
+		cache.simplexSize = s.size();
+		for (int i = 0; i < s.size(); ++i)
+		{
+			cache.simplexVertices[i] = s.index(i);
+		}
+
+		return { closest, region };
+	};
 	
 	while (true)
 	{
@@ -404,49 +492,63 @@ std::pair<vec2, Voronoi> ConvexPolygon::closestPoint(const vec2& point)
 		if (region == Voronoi::Inside)
 		{
 			// NOTE: previously first return value was "point" 
-			return { closest, region };
+			return finish(closest, region);
 		}
 
-		const Vertex* newSupport = supportVertex(d);
+		// The search direction turns less and less as GJK converges, so climb from the last support vertex
+		int newSupport = supportVertex(d, support);
 
 		if (s.contains(newSupport) || isZero(d))
 		{
-			return { closest, region };
+			return finish(closest, region);
 		}
 
-		s.addVertex(newSupport); 
+		support = newSupport;
+		s.addVertex(newSupport, vertex(newSupport)); 
 
 		// Terminate after a set number of iterations
 		if (++nIter >= ps.maxIterGJK)
 		{
 			//std::cout << "max GJK iterations exceeded\n";
-			return { closest, region };
+			return finish(closest, region);
 		}
 	}
 }
 
-const Vertex* ConvexPolygon::supportVertex(const vec2& d) const
+int ConvexPolygon::supportVertex(const vec2& d, int start) const
 {
-	real largestDot = std::numeric_limits<real>::lowest();
+	// The polygon is convex, so the vertices furthest in direction d can be reached from any
+	// vertex by repeatedly moving to whichever neighbour is further. Once a direction starts
+	// improving, the other one can't.
+	const real* x = xs(GlobalVertex);
+	const real* y = ys(GlobalVertex);
 
-	Vertex* vertex = nullptr;
-	for (auto& v : vertices)
-	{
-		real dotProduct = dot(v->global(), d);
+	int vertex = start;
+	real largestDot = x[vertex] * d.x + y[vertex] * d.y;
 
-		if (dotProduct > largestDot)
+	for (bool forwards : { true, false })
+	{
+		while (true)
 		{
+			int neighbour = forwards ? nextIndex(vertex) : prevIndex(vertex);
+			real dotProduct = x[neighbour] * d.x + y[neighbour] * d.y;
+
+			if (dotProduct <= largestDot)
+			{
+				break;
+			}
+
 			largestDot = dotProduct;
-			vertex = v.get();
+			vertex = neighbour;
 		}
 	}
 
 	return vertex;
 }
 
-void ConvexPolygon::createRegularPolygon(real sideLength)
+std::vector<vec2> ConvexPolygon::regularPolygon(real sideLength) const
 {
-	assert(vertices.empty());
+	std::vector<vec2> points;
 
 	real centralAngle = 2 * pi / npoints;
 	real r = sideLength / (2 * std::sin(centralAngle / 2));
@@ -459,10 +561,10 @@ void ConvexPolygon::createRegularPolygon(real sideLength)
 		// Bottom-right corner makes angle (90 - theta/2) deg with horizontal
 		pointAngle += pi / 2 - centralAngle / 2;
 
-		vec2 point = { r * std::cos(pointAngle), r * std::sin(pointAngle)};
-
-		vertices.emplace_back(std::make_unique<Vertex>(i, point, *this));
+		points.push_back({ r * std::cos(pointAngle), r * std::sin(pointAngle) });
 	}
+
+	return points;
 }
 
 void ConvexPolygon::setupRegularPolyMOI(real sideLength)
@@ -474,39 +576,60 @@ void ConvexPolygon::setupRegularPolyMOI(real sideLength)
 	setIInv(preFactor / trigFactor);
 }
 
-void ConvexPolygon::initialise()
+void ConvexPolygon::initialise(const std::vector<vec2>& points)
 {
-	// Common setup after Vertex coordinates have been established
+	soa.resize(FieldCount * 2 * npoints);
+
+	for (int i = 0; i < npoints; ++i)
+	{
+		set(LocalVertex, i, points[i]);
+	}
+
 	centreOnCOM();
 	setIInv(calculateInvMOI());
-	initEdges();
+	initNormals();
+	shrinkToCore();
 	initShape();
+
+	onMove();
 }
 
-void ConvexPolygon::initEdges()
+void ConvexPolygon::initNormals()
 {
-	assert(edges.empty());
-	
-	// First populate the edge vector
 	for (int i = 0; i < npoints; ++i)
 	{
-		vec2 localEdge = vertices[nextIndex(i)]->local() - vertices[i]->local();
-		edges.emplace_back(std::make_unique<Edge>(i, localEdge, *this));
+		vec2 localEdge = get(LocalVertex, nextIndex(i)) - get(LocalVertex, i);
+		set(LocalNormal, i, perp(normalise(localEdge)));
 	}
+}
+
+void ConvexPolygon::shrinkToCore()
+{
+	// Keep the core's edges at least half of the original distance from the centre of mass
+	real minEdgeDistance = std::numeric_limits<real>::max();
 
-	// Now link the edges & vertices together
 	for (int i = 0; i < npoints; ++i)
 	{
-		int iPrev = prevIndex(i), iNext = nextIndex(i);
+		minEdgeDistance = std::min(minEdgeDistance, dot(get(LocalVertex, i), get(LocalNormal, i)));
+	}
+
+	skin = std::clamp(static_cast<real>(0.5) * minEdgeDistance, static_cast<real>(0), ps.polygonRadius);
 
-		edges[i]->linkPrev(edges[iPrev].get());
-		edges[i]->linkNext(edges[iNext].get());
+	// Each vertex moves to where its two edges meet once they've been moved in, which is along the
+	// sum of their normals. The normals don't change.
+	std::vector<vec2> core(npoints);
+
+	for (int i = 0; i < npoints; ++i)
+	{
+		vec2 n1 = get(LocalNormal, prevIndex(i));
+		vec2 n2 = get(LocalNormal, i);
 
-		edges[i]->linkv1(vertices[i].get());
-		edges[i]->linkv2(vertices[iNext].get());
+		core[i] = get(LocalVertex, i) - skin * (n1 + n2) / (1 + dot(n1, n2));
+	}
 
-		vertices[i]->linke1(edges[iPrev].get());
-		vertices[i]->linke2(edges[i].get());
+	for (int i = 0; i < npoints; ++i)
+	{
+		set(LocalVertex, i, core[i]);
 	}
 }
 
@@ -519,7 +642,9 @@ void ConvexPolygon::initShape()
 
 	shape.setFillColor(col);
 	shape.setOutlineColor(sf::Color::Black);
-	shape.setOutlineThickness(-1);
+
+	// Only the core is filled, and the outline is drawn over the skin
+	shape.setOutlineThickness(std::max(skin * ps.pixPerUnit, static_cast<real>(1)));
 
 	shape.setPointCount(npoints);
 }
@@ -3,8 +3,6 @@
 #include "RigidBody.h"
 #include "PolyPolyContact.h"
 #include "PolyCircleContact.h"
-#include "Edge.h"
-#include "Vertex.h"
 #include "Simplex.h"
 #include <unordered_map>
 #include <map>
@@ -17,57 +15,96 @@ public:
 
 	void draw(sf::RenderWindow& window, real fraction, bool debug, sf::Text* text) override;
 
-	std::unique_ptr<ContactConstraint> checkCollision(RigidBody* other) override { return other->checkCollision(this); }
-	std::unique_ptr<ContactConstraint> checkCollision(ConvexPolygon* other) override;
-	std::unique_ptr<ContactConstraint> checkCollision(Circle* other) override;
+	// Return whether the bodies are in contact or less than margin apart, and if so fill in manifold.
+	// cache persists between calls for the same pair of polygons.
+	bool checkCollision(ConvexPolygon* other, real margin, PairCache& cache, ContactManifold& manifold);
+	bool checkCollision(Circle* other, real margin, PairCache& cache, ContactManifold& manifold);
 
 	void updateAABB() override;
-	void updateFatAABB() override;
 	bool pointInside(const vec2& p) const override;
 
 	void onMove() override;
 
-	vec2 edge(int i) const { return edges[i]->global(); }
-	vec2 vertex(int i) const { return vertices[i]->global(); }
-	vec2 normal(int i) const { return edges[i]->normal(); }
+	// The vertices are those of the polygon's core. The shape that collides is the core
+	// surrounded by a skin of this radius, which covers the polygon as it was given.
+	real skinRadius() const { return skin; }
+
+	// Edge i runs from vertex i to vertex nextIndex(i), and normal i is its outward unit normal
+	vec2 edge(int i) const { return vertex(nextIndex(i)) - vertex(i); }
+	vec2 vertex(int i) const { return get(GlobalVertex, i); }
+	vec2 normal(int i) const { return get(GlobalNormal, i); }
 
 	int nextIndex(int i) const;
 	int prevIndex(int i) const;
 
-	std::pair<vec2, Voronoi> closestPoint(const vec2& point);
+	// GJK, starting from the simplex stored in cache if there is one. The final simplex is stored back.
+	std::pair<vec2, Voronoi> closestPoint(const vec2& point, PairCache& cache);
 
 
 private:
-	void createRegularPolygon(real sideLength);
+	// Per-vertex data is stored in one buffer, as npoints x coordinates followed by
+	// npoints y coordinates for each field in turn
+	enum Field { LocalVertex, LocalNormal, GlobalVertex, GlobalNormal, FieldCount };
+
+	real* xs(Field f) { return soa.data() + 2 * f * npoints; }
+	real* ys(Field f) { return xs(f) + npoints; }
+	const real* xs(Field f) const { return soa.data() + 2 * f * npoints; }
+	const real* ys(Field f) const { return xs(f) + npoints; }
+
+	vec2 get(Field f, int i) const { return { xs(f)[i], ys(f)[i] }; }
+	void set(Field f, int i, const vec2& v) { xs(f)[i] = v.x; ys(f)[i] = v.y; }
+
+	std::vector<vec2> regularPolygon(real sideLength) const;
 	void setupRegularPolyMOI(real sideLength);
 
-	void initialise();
+	void initialise(const std::vector<vec2>& points);
 
 	void centreOnCOM();
 
 	vec2 calculateCOM() const;
 	real calculateInvMOI() const;
 
-	void initEdges();
+	void initNormals();
 	void initShape();
 
-	const Vertex* supportVertex(const vec2& d) const;
+	// Move every edge inwards by the skin radius, which is reduced for polygons too thin to take it all
+	void shrinkToCore();
+
+	// Vertex furthest in direction d, found by climbing around the polygon from start.
+	// Cheap when start is the result of a previous query in a similar direction.
+	int supportVertex(const vec2& d, int start) const;
 
-	// Find penetration of other polygon into this polygon along normal of edge e
-	std::pair<real, const Vertex*> normalPenetration(const Edge* e, const ConvexPolygon& other) const;
+	// Find penetration of other polygon into this polygon along normal of edge e,
+	// starting the search for the deepest vertex from hint
+	std::pair<real, int> normalPenetration(int e, const ConvexPolygon& other, int hint) const;
 
-	// Find maximum signed penetration of other polygon into this polygon along any edge normal
-	std::tuple<bool, real, const Edge*, const Vertex*> maxSignedPenetration(const ConvexPolygon& other) const;
+	// Find maximum signed penetration of other polygon into this polygon along any edge normal,
+	// stopping early if it exceeds margin
+	std::tuple<bool, real, int, int> maxSignedPenetration(const ConvexPolygon& other, real margin) const;
 
-	real absEdgeDot(const Edge* e, const vec2& d) const;
+	real absEdgeDot(int e, const vec2& d) const;
+
+	static void setPolyPolyManifold(ContactManifold& manifold, ConvexPolygon* ref, ConvexPolygon* inc, int refEdge, int incEdge, real margin);
+	void setPolyCircleManifold(ContactManifold& manifold, Circle* circle, const vec2& localNormal, const vec2& localRefPoint, Voronoi region);
+
+	// Pose of other relative to this polygon
+	std::pair<vec2, real> relativePose(const ConvexPolygon& other) const;
+
+	// Whether the reference and incident edges cached for a touching pair can be reused,
+	// because the relative pose of the polygons has barely changed since they were found
+	bool cachedFeaturesValid(const ConvexPolygon& inc, const PairCache& cache) const;
 
 	const int npoints;
-	std::vector<std::unique_ptr<Edge>> edges;
-	std::vector<std::unique_ptr<Vertex>> vertices;
+	std::vector<real> soa;
+
+	real skin = 0;
 
 	sf::ConvexShape shape;
 
-	std::unordered_map<idType, vec2> separatingAxes;
-	
-	std::pair<real, real> shadow(const vec2& n);
+	// Extent of the polygon along n. lowest and highest are the support vertices
+	// in the -n and n directions, which are updated in place.
+	std::pair<real, real> shadow(const vec2& n, int& lowest, int& highest) const;
+
+	// Support vertices in the -x, x, -y and y directions when the AABB was last updated
+	std::array<int, 4> aabbSupport{};
 };
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+#include <memory>
+
+template <typename Signature>
+class FunctionRef;
+
+// Non-owning reference to a callable, used for callbacks that need to pass through a virtual
+// function. Unlike std::function, it never allocates, but the callable must outlive it.
+template <typename R, typename... Args>
+class FunctionRef<R(Args...)>
+{
+public:
+	template <typename F>
+		requires (!std::is_same_v<std::remove_cvref_t<F>, FunctionRef> && std::is_invocable_r_v<R, F&, Args...>)
+	FunctionRef(F&& f):
+		callable(const_cast<void*>(static_cast<const void*>(std::addressof(f)))),
+		invoker([](void* c, Args... args) -> R
+		{
+			return (*static_cast<std::remove_reference_t<F>*>(c))(std::forward<Args>(args)...);
+		})
+	{
+
+	}
+
+	R operator()(Args... args) const
+	{
+		return invoker(callable, std::forward<Args>(args)...);
+	}
+
+private:
+	void* callable;
+	R (*invoker)(void*, Args...);
+};
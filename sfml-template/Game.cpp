@@ -1,8 +1,11 @@
 #include "Game.h"
+#include <iostream>
+#include <iomanip>
 
 
 Game::Game():
-	mh(window, ps)
+	mh(window, ps),
+	contactPool(ps)
 {
 	sf::ContextSettings settings;
 	settings.antialiasingLevel = 4;
@@ -24,6 +27,8 @@ Game::Game():
 	text.setFont(font);
 	text.setFillColor(sf::Color::Blue);
 
+	createBroadphase();
+
 	real w = pixWidth / ps.pixPerUnit;
 	real h = pixHeight / ps.pixPerUnit;
 
@@ -82,6 +87,8 @@ Game::Game():
 
 	addCar(cd, { 1, 1 });
 
+	//addHammer({ 12, 0.5 }, 20);
+
 	//addSoftBody({ 10, 1 }, 12, 12, 0.1, 0.1, 0.0475, 100, 0.06, 1); 
 	
 	//addSoftBody({ 10, 1 }, 6, 8, 0.3, 0.3, 0.14, 80, 0.06, 1);
@@ -91,10 +98,8 @@ Game::Game():
 
 
 	// TODO: zero friction / restitution between soft body particles?
-	// TODO: continuous collision
 	// TODO: chain shape equivalent
 	// TODO: set up mass based on density?
-	// TODO: compound RigidBody made of multiple shapes
 
 
 	/*addCircle(2, pixToCoords(pixWidth * 0.5, pixHeight * 0.75));
@@ -108,6 +113,10 @@ Game::Game():
 	constraints.push_back(std::move(c));*/
 
 	//addCircle(0.5, { 3,3 }, 2);
+
+	broadphase->build(pendingProxies);
+	pendingProxies.clear();
+	loadingScene = false;
 }
 
 
@@ -156,6 +165,16 @@ void Game::run()
 				}
 			}
 
+			if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::B)
+			{
+				benchmarkBroadphase();
+			}
+
+			if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::N)
+			{
+				benchmarkCircleNarrowphase();
+			}
+
 			if (event.type == sf::Event::MouseButtonReleased)
 			{
 				if (event.mouseButton.button == sf::Mouse::Left)
@@ -222,9 +241,9 @@ void Game::run()
 			}
 		}
 
-		if (ps.showAABBTree)
+		if (ps.showBroadphase)
 		{
-			tree.draw(window, ps.pixPerUnit);
+			broadphase->draw(window, ps.pixPerUnit);
 		}
 
 		showStats(dt);
@@ -235,10 +254,14 @@ void Game::run()
 
 void Game::integrateVelocities()
 {
+	// Bodies in a compound move with it, so are skipped here and below
 	std::for_each(std::execution::unseq, rigidBodies.begin(), rigidBodies.end(), [&](const std::unique_ptr<RigidBody>& rb)
 	{
-		rb->integrateVel(ps.dt);
-		rb->applyDamping(ps.dt);
+		if (!rb->inCompound())
+		{
+			rb->integrateVel(ps.dt);
+			rb->applyDamping(ps.dt);
+		}
 	});
 }
 
@@ -246,7 +269,10 @@ void Game::integratePositions()
 {
 	std::for_each(std::execution::unseq, rigidBodies.begin(), rigidBodies.end(), [&](const std::unique_ptr<RigidBody>& rb)
 	{
-		rb->integratePos(ps.dt);
+		if (!rb->inCompound())
+		{
+			rb->integratePos(ps.dt);
+		}
 	});
 }
 
@@ -312,7 +338,10 @@ void Game::correctPositions()
 	// The onMove() function is not called every iteration
 	std::for_each(std::execution::unseq, rigidBodies.begin(), rigidBodies.end(), [](const std::unique_ptr<RigidBody>& rb)
 	{
-		rb->onMove();
+		if (!rb->inCompound())
+		{
+			rb->onMove();
+		}
 	});
 }
 
@@ -324,72 +353,168 @@ void Game::updateCollidingPairs()
 		cp.second->markForRemoval();
 	});
 
-	std::for_each(std::execution::unseq, rigidBodies.begin(), rigidBodies.end(), [&](const std::unique_ptr<RigidBody>& rb)
+	broadphase->resetStepStats();
+
+	movingBodies.clear();
+	for (auto& rb : rigidBodies)
+	{
+		// Compound bodies have no proxy, but their children do
+		if (!rb->isStatic() && !rb->isCompound())
+		{
+			movingBodies.push_back(rb.get());
+		}
+	}
+
+	std::for_each(std::execution::par_unseq, movingBodies.begin(), movingBodies.end(), [](RigidBody* rb)
 	{
 		rb->updateAABB();
-		tree.update(rb.get());
 	});
 
-	// Note: parallel processing actually slows this down, presumably because of the
-	// requirement for a mutex lock before accessing the contact constraint map
+	broadphase->updateBatch(movingBodies);
+
+	broadphase->updatePairs();
+
+	candidatePairs.clear();
+	broadphase->getPairs(candidatePairs);
+
+	circleBatch.clear();
 
-	std::for_each(std::execution::seq, rigidBodies.begin(), rigidBodies.end(), 
-	[&](const std::unique_ptr<RigidBody>& rb)
+	std::erase_if(candidatePairs, [&](const ProxyPair& pair)
 	{
-		// colliders will only contain rigid bodies with id less than rb's id
-		auto colliders = tree.getPossibleColliders(rb.get());
-		
-		for (auto& c : colliders)
+		// Don't try to collide two rigid bodies of infinite mass
+		if (!pair.rb1->canCollideWith(pair.rb2) || !(pair.rb1->mInv() || pair.rb2->mInv()))
 		{
-			// Don't try to collide two rigid bodies of infinite mass
-			if (c->canCollideWith(rb.get()) && (c->mInv() || rb->mInv()))
-			{
-				checkCollision(c, rb.get());
-			}
+			return true;
 		}
+
+		// Circle-circle pairs are moved into a batch and tested together.
+		// The circle with the higher id comes first, as in collideCircles().
+		if (shapePairIndex(pair.rb1, pair.rb2) == shapePairIndex(Shape::Circle, Shape::Circle))
+		{
+			circleBatch.add(static_cast<Circle*>(pair.rb2), static_cast<Circle*>(pair.rb1));
+			return true;
+		}
+
+		return false;
 	});
 
-	// Any previously colliding pairs that are no longer in contact should be removed
-	std::erase_if(collidingPairs, [](const auto& cp) { return cp.second->removeFlagSet(); });
-}
+	// Run the narrow phase in parallel, with one preallocated result slot per pair, so that no
+	// thread ever writes anywhere another can. The first slots belong to candidatePairs and the rest
+	// to the circle batch. Constraints that persist are updated in place, which only reads the
+	// contact constraint map.
+	int nPairs = candidatePairs.size();
+	narrowPhaseCandidates = nPairs + circleBatch.size();
+	narrowPhaseSlots.resize(narrowPhaseCandidates);
 
-void Game::checkCollision(RigidBody* rb1, RigidBody* rb2)
-{
-	// Assumes that the ordering of rb1 and rb2 is always consistent, e.g. rb1->id < rb2->id
+	auto onContact = [&](NarrowPhaseSlot& slot, const idPair& ids, const ContactManifold& manifold)
+	{
+		auto it = collidingPairs.find(ids);
 
-	std::unique_ptr<ContactConstraint> result = rb1->checkCollision(rb2);
+		if (it != collidingPairs.end() && it->second->matches(manifold))
+		{
+			it->second->refresh(manifold);
+			slot.result = NarrowPhaseSlot::Result::Refreshed;
+		}
+		else
+		{
+			slot.result = NarrowPhaseSlot::Result::New;
+			slot.ids = ids;
+			slot.manifold = manifold;
+		}
+	};
 
-	if (result)
+	// Pairs are scheduled individually rather than in fixed chunks, since their cost varies
+	// a lot (two boxes in a dense pile take far longer than two bodies that barely overlap)
+	std::for_each(std::execution::par, narrowPhaseSlots.begin(), narrowPhaseSlots.begin() + nPairs, [&](NarrowPhaseSlot& slot)
 	{
-		result->init();
+		const ProxyPair& pair = candidatePairs[&slot - narrowPhaseSlots.data()];
+		ContactManifold manifold;
+
+		slot.result = NarrowPhaseSlot::Result::Separated;
 
-		idPair pair = { rb1->id, rb2->id };
+		if (checkCollision(pair, manifold))
+		{
+			onContact(slot, { pair.rb1->id, pair.rb2->id }, manifold);
+		}
+	});
 
-		auto it = collidingPairs.find(pair);
+	// Circle pairs all cost about the same, so they're split evenly to keep whole SIMD batches together
+	const std::vector<int>& workers = workerIndices();
 
-		if (it == collidingPairs.end())
+	std::for_each(std::execution::par, workers.begin(), workers.end(), [&](int w)
+	{
+		auto [begin, end] = chunkRange(circleBatch.size(), w, workers.size());
+
+		for (int i = begin; i < end; ++i)
 		{
-			// This pair is newly colliding
-			collidingPairs.insert({ pair, std::move(result) });
+			narrowPhaseSlots[nPairs + i].result = NarrowPhaseSlot::Result::Separated;
 		}
-		else
+
+		circleBatch.collide(begin, end, [&](int i, const ContactManifold& manifold)
 		{
-			// This pair was already colliding, so take the impulses for warm starting
-			result->getImpulsesFrom(it->second.get());
-			it->second = std::move(result);
+			onContact(narrowPhaseSlots[nPairs + i], { circleBatch.second(i)->id, circleBatch.first(i)->id }, manifold);
+		});
+	});
+
+	// Add the new contacts in pair order, so the result doesn't depend on thread timing
+	for (const NarrowPhaseSlot& slot : narrowPhaseSlots)
+	{
+		if (slot.result == NarrowPhaseSlot::Result::New)
+		{
+			storeContact(slot.ids, slot.manifold);
 		}
 	}
+
+	// Any previously colliding pairs that are no longer in contact should be removed
+	std::erase_if(collidingPairs, [&](const auto& cp)
+	{
+		if (cp.second->removeFlagSet())
+		{
+			contactPool.destroy(cp.second);
+			return true;
+		}
+
+		return false;
+	});
+
+	narrowPhaseContacts = collidingPairs.size();
+}
+
+bool Game::checkCollision(const ProxyPair& pair, ContactManifold& manifold) const
+{
+	// Assumes that the ordering of rb1 and rb2 is always consistent, e.g. rb1->id < rb2->id
+	// Note: may be called from several threads at once, but never for the same pair
+
+	return collide(pair.rb1, pair.rb2, *pair.cache, manifold);
+}
+
+void Game::storeContact(const idPair& pair, const ContactManifold& manifold)
+{
+	auto it = collidingPairs.find(pair);
+
+	if (it == collidingPairs.end())
+	{
+		// This pair is newly colliding
+		collidingPairs.insert({ pair, contactPool.create(manifold) });
+	}
+	else
+	{
+		// The bodies have swapped roles (e.g. reference and incident polygon), so the old
+		// contact points can't be matched up with the new ones and a new constraint is needed
+		contactPool.destroy(it->second);
+		it->second = contactPool.create(manifold);
+	}
 }
 
 void Game::removeClickedRigidBody()
 {
-	auto containers = tree.getPossibleContainers(mh.coords());
+	auto containers = broadphase->getPossibleContainers(mh.coords());
 
 	for (auto& rb : containers)
 	{
 		if (rb->pointInside(mh.coords()))
 		{
-			rb->markForRemoval();
+			rb->body()->markForRemoval();
 			break;
 		}
 	}
@@ -421,11 +546,28 @@ void Game::handleConstraintRemoval()
 
 void Game::handleRigidBodyRemoval()
 {
+	// Children are removed along with their compound
+	for (auto& rb : rigidBodies)
+	{
+		if (rb->isCompound() && rb->removeFlagSet())
+		{
+			for (RigidBody* child : static_cast<CompoundBody*>(rb.get())->getChildren())
+			{
+				child->setAsRemovable();
+				child->markForRemoval();
+			}
+		}
+	}
+
 	for (auto it = rigidBodies.begin(); it != rigidBodies.end(); )
 	{
 		if ((*it)->removeFlagSet())
 		{
-			tree.remove(it->get());
+			if (!(*it)->isCompound())
+			{
+				broadphase->remove(it->get());
+			}
+
 			it = rigidBodies.erase(it);
 		}
 		else
@@ -439,17 +581,19 @@ void Game::setupMouseConstraint()
 {
 	if (!mc)
 	{
-		auto containers = tree.getPossibleContainers(mh.coords());
+		auto containers = broadphase->getPossibleContainers(mh.coords());
 
 		for (auto& rb : containers)
 		{
 			if (rb->pointInside(mh.coords()))
 			{
-				vec2 local = rb->pointToLocal(mh.coords());// { 0, 0 };
+				// Drag the whole compound if the body is part of one
+				RigidBody* body = rb->body();
+				vec2 local = body->pointToLocal(mh.coords());// { 0, 0 };
 				real fMax = 150.f; // / rb->mInv();
 
 				// TODO: Consider force/acceleration limit & contact breaking
-				auto newMC = std::make_unique<MouseConstraint>(rb, mh, ps, local, .05f, 5.f, fMax);
+				auto newMC = std::make_unique<MouseConstraint>(body, mh, ps, local, .05f, 5.f, fMax);
 				mc = newMC.get();
 
 				constraints.push_back(std::move(newMC));
@@ -474,11 +618,19 @@ void Game::showStats(real frameTime)
 	text.setCharacterSize(30);
 	text.setFillColor(sf::Color::Black);
 
+	BroadphaseStats bpStats = broadphase->getStats();
+	real contactFraction = narrowPhaseCandidates > 0 ? real(narrowPhaseContacts) / narrowPhaseCandidates : 0;
+
 	std::stringstream ss;
 	ss << "FPS: " << std::fixed << std::setprecision(0) << 1. / frameTime << '\n'
 		<< "Rigid bodies: " << rigidBodies.size() << '\n'
 		<< "Constraints: " << constraints.size() << '\n'
 		<< "Contact constraints: " << collidingPairs.size() << '\n'
+		<< "Broad phase proxies: " << bpStats.proxies << ", height: " << bpStats.height
+		<< ", internal perimeter: " << bpStats.internalPerimeter << '\n'
+		<< "Reinserts: " << bpStats.reinserts << ", refits: " << bpStats.refits << ", rotations: " << bpStats.rotations << '\n'
+		<< "Candidate pairs: " << bpStats.candidatePairs << ", narrow phase: " << narrowPhaseCandidates
+		<< ", contacts: " << narrowPhaseContacts << " (" << contactFraction * 100 << "%)" << '\n'
 		<< "Physics frequency: " << 1. / ps.dt << " Hz" << '\n'
 		<< "Velocity iterations: " << ps.velIter << '\n'
 		<< "Position iterations: " << ps.posIter << '\n';
@@ -488,6 +640,181 @@ void Game::showStats(real frameTime)
 	window.draw(text);
 }
 
+void Game::benchmarkBroadphase()
+{
+	PhysicsSettings binarySettings = ps;
+	binarySettings.useWideBVH = false;
+
+	PhysicsSettings wideSettings = ps;
+	wideSettings.useWideBVH = true;
+
+	AABBTree binaryTree(binarySettings);
+	AABBTree wideTree(wideSettings);
+
+	std::vector<RigidBody*> bodies;
+	for (auto& rb : rigidBodies)
+	{
+		if (!rb->isCompound())
+		{
+			bodies.push_back(rb.get());
+		}
+	}
+
+	// The bodies can only hold one proxy index, which belongs to the game's own broad phase.
+	// Clear it while the benchmark trees are built, and put it back afterwards.
+	std::vector<int> savedProxies;
+	for (RigidBody* rb : bodies)
+	{
+		savedProxies.push_back(rb->proxyIndex());
+		rb->setProxyIndex(-1);
+	}
+
+	// updatePairs() also builds the wide BVH
+	binaryTree.build(bodies);
+	binaryTree.updatePairs();
+
+	for (RigidBody* rb : bodies)
+	{
+		rb->setProxyIndex(-1);
+	}
+
+	wideTree.build(bodies);
+	wideTree.updatePairs();
+
+	for (int i = 0; i < static_cast<int>(bodies.size()); ++i)
+	{
+		bodies[i]->setProxyIndex(savedProxies[i]);
+	}
+
+	real w = pixWidth / ps.pixPerUnit;
+	real h = pixHeight / ps.pixPerUnit;
+
+	std::mt19937 gen(0);
+	std::uniform_real_distribution<real> x(0, w), y(0, h);
+
+	std::vector<RayCastInput> rays(10000);
+	for (RayCastInput& ray : rays)
+	{
+		ray.p1 = { x(gen), y(gen) };
+		ray.p2 = { x(gen), y(gen) };
+	}
+
+	constexpr int repeats = 20;
+
+	auto timeQueries = [&](const AABBTree& tree, int& hits)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < repeats; ++i)
+		{
+			for (RigidBody* rb : bodies)
+			{
+				tree.queryAABB(rb->getFatAABB(), [&](RigidBody*) { ++hits; });
+			}
+		}
+
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeats;
+	};
+
+	auto timeRays = [&](const AABBTree& tree, int& hits)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < repeats; ++i)
+		{
+			for (const RayCastInput& ray : rays)
+			{
+				tree.rayCast(ray, [&](const RayCastInput& input, RigidBody*)
+				{
+					++hits;
+					return input.maxFraction;
+				});
+			}
+		}
+
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeats;
+	};
+
+	int binaryQueryHits = 0, wideQueryHits = 0, binaryRayHits = 0, wideRayHits = 0;
+
+	double binaryQueryTime = timeQueries(binaryTree, binaryQueryHits);
+	double wideQueryTime = timeQueries(wideTree, wideQueryHits);
+	double binaryRayTime = timeRays(binaryTree, binaryRayHits);
+	double wideRayTime = timeRays(wideTree, wideRayHits);
+
+	std::cout << std::fixed << std::setprecision(1)
+		<< "Broad phase benchmark, " << bodies.size() << " proxies (average time per pass)\n"
+		<< bodies.size() << " AABB queries: binary " << binaryQueryTime << " us, wide " << wideQueryTime << " us ("
+		<< binaryQueryHits / repeats << " / " << wideQueryHits / repeats << " hits)\n"
+		<< rays.size() << " ray casts: binary " << binaryRayTime << " us, wide " << wideRayTime << " us ("
+		<< binaryRayHits / repeats << " / " << wideRayHits / repeats << " hits)\n";
+}
+
+void Game::benchmarkCircleNarrowphase()
+{
+	constexpr int numPairs = 20000;
+	constexpr int repeats = 20;
+
+	// The second circle of each pair is placed close enough to the first that about half of them touch
+	std::mt19937 gen(0);
+	std::uniform_real_distribution<real> coord(0, 10), offset(-0.5, 0.5), rad(0.1, 0.3);
+
+	std::vector<std::unique_ptr<Circle>> circles;
+	for (int i = 0; i < numPairs; ++i)
+	{
+		vec2 p = { coord(gen), coord(gen) };
+
+		circles.push_back(std::make_unique<Circle>(ps, rad(gen)));
+		circles.back()->moveTo(p);
+
+		circles.push_back(std::make_unique<Circle>(ps, rad(gen)));
+		circles.back()->moveTo(p + vec2(offset(gen), offset(gen)));
+	}
+
+	PairCache cache;
+	ContactManifold manifold;
+	int scalarHits = 0, batchHits = 0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int r = 0; r < repeats; ++r)
+	{
+		for (int i = 0; i < numPairs; ++i)
+		{
+			scalarHits += collide(circles[2 * i].get(), circles[2 * i + 1].get(), cache, manifold);
+		}
+	}
+
+	double scalarTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+	// Gathering the pairs into the batch is timed separately from the tests themselves
+	CircleBatch batch;
+	double gatherTime = 0, batchTime = 0;
+
+	for (int r = 0; r < repeats; ++r)
+	{
+		start = std::chrono::steady_clock::now();
+
+		batch.clear();
+		for (int i = 0; i < numPairs; ++i)
+		{
+			batch.add(circles[2 * i + 1].get(), circles[2 * i].get());
+		}
+
+		auto gathered = std::chrono::steady_clock::now();
+
+		batch.collide(0, batch.size(), [&](int, const ContactManifold&) { ++batchHits; });
+
+		gatherTime += std::chrono::duration<double, std::micro>(gathered - start).count() / repeats;
+		batchTime += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - gathered).count() / repeats;
+	}
+
+	std::cout << std::fixed << std::setprecision(1)
+		<< "Circle narrow phase benchmark, " << numPairs << " pairs (average time per pass)\n"
+		<< "scalar " << scalarTime << " us, batched " << batchTime << " us + " << gatherTime << " us to gather ("
+		<< scalarHits / repeats << " / " << batchHits / repeats << " hits)\n";
+}
+
 ConvexPolygon* Game::addConvexPolygon(int nsides, real len, vec2 coords, real mInv)
 {
 	auto rb = std::make_unique<ConvexPolygon>(ps, nsides, len, mInv);
@@ -495,7 +822,7 @@ ConvexPolygon* Game::addConvexPolygon(int nsides, real len, vec2 coords, real mI
 
 	ConvexPolygon* rawPointer = rb.get();
 
-	addToAABBTree(rawPointer);
+	addToBroadphase(rawPointer);
 	rigidBodies.push_back(std::move(rb));
 
 	return rawPointer;
@@ -508,7 +835,7 @@ ConvexPolygon* Game::addConvexPolygon(const std::vector<vec2>& points, vec2 coor
 
 	ConvexPolygon* rawPointer = rb.get();
 
-	addToAABBTree(rawPointer);
+	addToBroadphase(rawPointer);
 	rigidBodies.push_back(std::move(rb));
 
 	return rawPointer;
@@ -521,12 +848,37 @@ Circle* Game::addCircle(real rad, vec2 coords, real mInv)
 
 	Circle* rawPointer = rb.get();
 
-	addToAABBTree(rawPointer);
+	addToBroadphase(rawPointer);
 	rigidBodies.push_back(std::move(rb));
 
 	return rawPointer;
 }
 
+CompoundBody* Game::addCompound(const std::vector<RigidBody*>& children)
+{
+	auto compound = std::make_unique<CompoundBody>(ps, children);
+	CompoundBody* rawPointer = compound.get();
+
+	// Existing contacts apply their impulses to the children, so are replaced with new ones
+	std::erase_if(collidingPairs, [&](const auto& cp)
+	{
+		for (RigidBody* child : children)
+		{
+			if (cp.first.first == child->id || cp.first.second == child->id)
+			{
+				contactPool.destroy(cp.second);
+				return true;
+			}
+		}
+
+		return false;
+	});
+
+	rigidBodies.push_back(std::move(compound));
+
+	return rawPointer;
+}
+
 void Game::addChain(int nLinks, real linkWidth, real linkLength, vec2 start, real linkmInv, real angle)
 {
 	std::vector<vec2> pts = { {0, 0}, {linkLength, 0}, {linkLength, linkWidth}, {0, linkWidth} };
@@ -649,10 +1001,52 @@ void Game::addCar(CarDefinition cd, vec2 pos)
 	}
 }
 
-void Game::addToAABBTree(RigidBody* rb)
+void Game::addHammer(vec2 pos, real mInv)
+{
+	// A handle and a head, which would otherwise need a weld constraint to hold them together
+	ConvexPolygon* handle = addConvexPolygon({ {0, 0}, {1.2, 0}, {1.2, 0.12}, {0, 0.12} }, pos, mInv);
+	ConvexPolygon* head = addConvexPolygon({ {0, 0}, {0.25, 0}, {0.25, 0.6}, {0, 0.6} }, pos + vec2(0.6 + 0.125, 0), mInv);
+
+	addCompound({ handle, head });
+}
+
+void Game::createBroadphase()
+{
+	switch (ps.broadphase)
+	{
+	case BroadphaseType::AABBTree:
+		broadphase = std::make_unique<AABBTree>(ps);
+		break;
+
+	case BroadphaseType::SweepAndPrune:
+		broadphase = std::make_unique<SweepAndPrune>();
+		break;
+
+	case BroadphaseType::SpatialHashGrid:
+		broadphase = std::make_unique<SpatialHashGrid>(ps.gridCellSize);
+		break;
+
+	case BroadphaseType::Hybrid:
+		broadphase = std::make_unique<HybridBroadphase>(ps);
+		break;
+	}
+}
+
+void Game::addToBroadphase(RigidBody* rb)
 {
+	// Static bodies are never updated, so their AABBs must be correct from the start
+	rb->updateAABB();
 	rb->updateFatAABB();
-	tree.insert(rb);
+
+	if (loadingScene)
+	{
+		// Inserted all at once when the scene has finished loading
+		pendingProxies.push_back(rb);
+	}
+	else
+	{
+		broadphase->insert(rb);
+	}
 }
 
 DistanceConstraint* Game::addLimitedSpring(RigidBody* rb1, RigidBody* rb2, vec2 local1, vec2 local2, real dist, real tOsc, real damping, real frac, bool relativeToRefPoints)
@@ -4,7 +4,11 @@
 #include "RigidBody.h"
 #include "ConvexPolygon.h"
 #include "Circle.h"
+#include "CompoundBody.h"
 #include "ContactConstraint.h"
+#include "ContactPool.h"
+#include "Collide.h"
+#include "CircleBatch.h"
 #include "MouseConstraint.h"
 #include "DistanceConstraint.h"
 #include "LineConstraint.h"
@@ -12,9 +16,14 @@
 #include "MouseHandler.h"
 #include "PhysicsSettings.h"
 #include "AABBTree.h"
+#include "SweepAndPrune.h"
+#include "SpatialHashGrid.h"
+#include "HybridBroadphase.h"
 #include "PinConstraint.h"
 #include "WeldConstraint.h"
 #include "CarDefinition.h"
+#include <chrono>
+#include <random>
 
 
 
@@ -48,7 +57,8 @@ private:
 	void correctPositions();
 
 	void updateCollidingPairs();
-	void checkCollision(RigidBody* rb1, RigidBody* rb2);
+	bool checkCollision(const ProxyPair& pair, ContactManifold& manifold) const;
+	void storeContact(const idPair& pair, const ContactManifold& manifold);
 
 	void removeClickedRigidBody();
 
@@ -60,15 +70,27 @@ private:
 
 	void showStats(real frameTime);
 
+	// Time queries and ray casts against the binary AABBTree and the WideBVH, using the current bodies
+	void benchmarkBroadphase();
+
+	// Time the scalar and batched circle-circle tests on random pairs, and print the results
+	void benchmarkCircleNarrowphase();
+
 	ConvexPolygon* addConvexPolygon(int nsides, real len, vec2 coords = {0, 0}, real mInv = 0);
 	ConvexPolygon* addConvexPolygon(const std::vector<vec2>& points, vec2 coords = { 0, 0 }, real mInv = 0);
 	Circle* addCircle(real rad, vec2 coords = { 0, 0 }, real mInv = 0);
+
+	// Join bodies that have already been added into one rigid body, in their current poses.
+	// Constraints should be attached to the compound rather than to its children.
+	CompoundBody* addCompound(const std::vector<RigidBody*>& children);
 	
 	void addChain(int nLinks, real linkWidth, real linkLength, vec2 start = { 0, 0 }, real linkmInv = 0, real angle = 0);
 	void addSoftBody(vec2 minVertex, int nx, int ny, real xSpace, real ySpace, real particleRad, real particlemInv, real tOsc, real dampingRatio);
 	void addCar(CarDefinition cd, vec2 pos);
+	void addHammer(vec2 pos, real mInv);
 
-	void addToAABBTree(RigidBody* rb);
+	void createBroadphase();
+	void addToBroadphase(RigidBody* rb);
 
 	DistanceConstraint* addLimitedSpring(RigidBody* rb1, RigidBody* rb2, vec2 local1, vec2 local2, real dist, 
 		real tOsc, real damping, real frac, bool relativeToRefPoints = false);
@@ -81,11 +103,44 @@ private:
 	PhysicsSettings ps;
 	MouseHandler mh;
 	
-	AABBTree tree;
+	std::unique_ptr<Broadphase> broadphase;
+
+	// While the scene is being set up in the constructor, new bodies are
+	// collected here and then added to the broad phase in one go
+	bool loadingScene = true;
+	std::vector<RigidBody*> pendingProxies;
 
 	std::vector<std::unique_ptr<RigidBody>> rigidBodies;
 	std::vector<std::unique_ptr<Constraint>> constraints;
 
-	std::map<idPair, std::unique_ptr<ContactConstraint>> collidingPairs;
+	// Contact constraints persist for as long as their bodies stay in contact, and are owned by contactPool
+	ContactPool contactPool;
+	std::map<idPair, ContactConstraint*> collidingPairs;
+
+	// Non-static bodies, whose AABBs are updated every step
+	std::vector<RigidBody*> movingBodies;
+
+	// Broad phase pairs that pass the collision filter, except for circle-circle pairs which are
+	// gathered into a batch
+	std::vector<ProxyPair> candidatePairs;
+	CircleBatch circleBatch;
+
+	// Narrow phase result for one pair. Only new contacts, or those that couldn't be used
+	// to update an existing constraint, keep their manifold.
+	struct NarrowPhaseSlot
+	{
+		enum class Result : uint8_t { Separated, Refreshed, New };
+
+		Result result = Result::Separated;
+		idPair ids;
+		ContactManifold manifold;
+	};
+
+	// One slot per candidate pair, then one per pair in the circle batch
+	std::vector<NarrowPhaseSlot> narrowPhaseSlots;
+
+	// Pairs passed to the narrow phase during the last step, and how many of them were in contact
+	int narrowPhaseCandidates = 0;
+	int narrowPhaseContacts = 0;
 };
 
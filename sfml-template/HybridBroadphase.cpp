@@ -0,0 +1,192 @@
+#include "HybridBroadphase.h"
+
+HybridBroadphase::HybridBroadphase(const PhysicsSettings& ps):
+	cellSize(ps.gridCellSize), grid(ps.gridCellSize), tree(ps)
+{
+
+}
+
+void HybridBroadphase::insert(RigidBody* rb)
+{
+	if (belongsInGrid(rb))
+	{
+		grid.insert(rb);
+	}
+	else
+	{
+		tree.insert(rb);
+	}
+
+	moveBuffer.push_back(rb);
+}
+
+void HybridBroadphase::remove(RigidBody* rb)
+{
+	if (grid.holds(rb))
+	{
+		grid.remove(rb);
+	}
+	else
+	{
+		tree.remove(rb);
+	}
+
+	std::erase(moveBuffer, rb);
+	removePairs(rb);
+}
+
+void HybridBroadphase::update(RigidBody* rb)
+{
+	// Both structures reinsert a proxy exactly when it leaves its fat AABB
+	bool moved = !rb->getFatAABB().contains(rb->getAABB());
+
+	if (grid.holds(rb))
+	{
+		grid.update(rb);
+	}
+	else
+	{
+		tree.update(rb);
+	}
+
+	if (moved)
+	{
+		moveBuffer.push_back(rb);
+		++reinserts;
+	}
+}
+
+void HybridBroadphase::updateBatch(const std::vector<RigidBody*>& bodies)
+{
+	gridBodies.clear();
+	treeBodies.clear();
+
+	for (RigidBody* rb : bodies)
+	{
+		if (!rb->getFatAABB().contains(rb->getAABB()))
+		{
+			moveBuffer.push_back(rb);
+			++reinserts;
+		}
+
+		(grid.holds(rb) ? gridBodies : treeBodies).push_back(rb);
+	}
+
+	grid.updateBatch(gridBodies);
+	tree.updateBatch(treeBodies);
+}
+
+void HybridBroadphase::refreshFilter(RigidBody* rb)
+{
+	if (grid.holds(rb))
+	{
+		grid.refreshFilter(rb);
+	}
+	else
+	{
+		tree.refreshFilter(rb);
+	}
+
+	Broadphase::refreshFilter(rb);
+}
+
+void HybridBroadphase::build(const std::vector<RigidBody*>& bodies)
+{
+	gridBodies.clear();
+	treeBodies.clear();
+
+	for (RigidBody* rb : bodies)
+	{
+		if (belongsInGrid(rb))
+		{
+			gridBodies.push_back(rb);
+		}
+		else
+		{
+			treeBodies.push_back(rb);
+		}
+
+		moveBuffer.push_back(rb);
+	}
+
+	grid.build(gridBodies);
+	tree.build(treeBodies);
+}
+
+void HybridBroadphase::updatePairs()
+{
+	grid.updatePairs();
+	tree.updatePairs();
+
+	// Pairs with one proxy in each structure
+	addPairsForMoved([this](RigidBody* rb, std::vector<ProxyPair>& result)
+	{
+		auto addPair = [&](RigidBody* other)
+		{
+			result.push_back({ rb, other });
+		};
+
+		if (grid.holds(rb))
+		{
+			tree.query(rb->getFatAABB(), addPair, rb);
+		}
+		else
+		{
+			grid.query(rb->getFatAABB(), addPair, rb);
+		}
+	});
+}
+
+void HybridBroadphase::getPairs(std::vector<ProxyPair>& result) const
+{
+	grid.getPairs(result);
+	tree.getPairs(result);
+	Broadphase::getPairs(result);
+}
+
+void HybridBroadphase::queryAABB(const AABB& aabb, QueryCallback callback) const
+{
+	grid.queryAABB(aabb, callback);
+	tree.queryAABB(aabb, callback);
+}
+
+void HybridBroadphase::queryPoint(const vec2& p, QueryCallback callback) const
+{
+	grid.queryPoint(p, callback);
+	tree.queryPoint(p, callback);
+}
+
+void HybridBroadphase::draw(sf::RenderWindow& window, real pixPerUnit)
+{
+	grid.draw(window, pixPerUnit);
+	tree.draw(window, pixPerUnit);
+}
+
+bool HybridBroadphase::belongsInGrid(const RigidBody* rb) const
+{
+	AABB aabb = rb->getAABB();
+	vec2 size = aabb.upper - aabb.lower;
+
+	return rb->mInv() != 0 && size.x <= cellSize && size.y <= cellSize;
+}
+
+BroadphaseStats HybridBroadphase::getStats() const
+{
+	BroadphaseStats stats = tree.getStats();
+	BroadphaseStats gridStats = grid.getStats();
+
+	// Moved proxies are counted here rather than by the grid and tree, except
+	// for the split between reinserts and refits within the tree
+	stats.proxies += gridStats.proxies;
+	stats.reinserts = reinserts - stats.refits;
+	stats.candidatePairs += gridStats.candidatePairs + pairs.size();
+
+	return stats;
+}
+
+void HybridBroadphase::resetStepStats()
+{
+	Broadphase::resetStepStats();
+	grid.resetStepStats();
+	tree.resetStepStats();
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include "Utils.h"
+#include "RigidBody.h"
+#include "Broadphase.h"
+#include "SpatialHashGrid.h"
+#include "AABBTree.h"
+
+// Small dynamic bodies go in a SpatialHashGrid, while large or static bodies go in an AABBTree.
+// Pairs within each structure are found by that structure; pairs between the two are found
+// by querying the other structure with each moved proxy.
+class HybridBroadphase : public Broadphase
+{
+public:
+	// Bodies whose AABB fits within a single cell are placed in the grid
+	HybridBroadphase(const PhysicsSettings& ps);
+
+	void insert(RigidBody* rb) override;
+	void remove(RigidBody* rb) override;
+	void update(RigidBody* rb) override;
+	void updateBatch(const std::vector<RigidBody*>& bodies) override;
+
+	// Sort the bodies into the two structures, and bulk build each of them
+	void build(const std::vector<RigidBody*>& bodies) override;
+
+	void updatePairs() override;
+	void getPairs(std::vector<ProxyPair>& result) const override;
+
+	void queryAABB(const AABB& aabb, QueryCallback callback) const override;
+	void queryPoint(const vec2& p, QueryCallback callback) const override;
+
+	void draw(sf::RenderWindow& window, real pixPerUnit) override;
+
+	void refreshFilter(RigidBody* rb) override;
+
+	int count() const override { return grid.count() + tree.count(); }
+
+	BroadphaseStats getStats() const override;
+	void resetStepStats() override;
+
+private:
+	bool belongsInGrid(const RigidBody* rb) const;
+
+	const real cellSize;
+
+	SpatialHashGrid grid;
+	AABBTree tree;
+
+	std::vector<RigidBody*> gridBodies;
+	std::vector<RigidBody*> treeBodies;
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <vector>
+
+// Stack of node indices used when traversing a tree. Entries are stored inline, so a traversal
+// doesn't allocate unless the tree is far deeper than any reasonably balanced tree would be.
+class NodeStack
+{
+public:
+	bool empty() const { return size == 0; }
+
+	int top() const
+	{
+		return size <= capacity ? inlineNodes[size - 1] : overflow.back();
+	}
+
+	void push(int n)
+	{
+		if (size < capacity)
+		{
+			inlineNodes[size] = n;
+		}
+		else
+		{
+			overflow.push_back(n);
+		}
+
+		++size;
+	}
+
+	void pop()
+	{
+		if (size > capacity)
+		{
+			overflow.pop_back();
+		}
+
+		--size;
+	}
+
+private:
+	static constexpr int capacity = 256;
+
+	std::array<int, capacity> inlineNodes;
+	std::vector<int> overflow;
+	int size = 0;
+};
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Utils.h"
+
+class RigidBody;
+
+// Narrow phase results kept between steps for a pair of bodies, for as long
+// as the broad phase keeps reporting them as a pair
+struct PairCache
+{
+	// The body owning the edge that separated the pair, or that was used as the reference edge,
+	// when the pair was last tested. Null if nothing is cached yet.
+	const RigidBody* axisOwner = nullptr;
+	int axisEdge = -1;
+
+	bool separated = false;
+
+	// For touching pairs, the incident edge on the other body, and the pose of the other
+	// body relative to axisOwner when the reference and incident edges were chosen
+	int incidentEdge = -1;
+	vec2 relPosition;
+	real relAngle = 0;
+
+	// For polygon-circle pairs, the polygon vertices of the final GJK simplex, used as the
+	// starting simplex next time
+	std::array<int, 3> simplexVertices = {};
+	int simplexSize = 0;
+};
@@ -2,17 +2,29 @@
 
 #include "Utils.h"
 
+enum class BroadphaseType { AABBTree, SweepAndPrune, SpatialHashGrid, Hybrid };
+
 struct PhysicsSettings
 {
 	real dt = 1.0 / 500;
 	
 	bool showConstraints = false;
 	bool showContactConstraints = false;
-	bool showAABBTree = false;
+	bool showBroadphase = false;
 
 	real slop = 0.005;
 	real beta = 0.2;
 
+	// Contacts are created speculatively between bodies that are up to speculativeDistance apart,
+	// plus however far they could approach each other during the step. The solver then lets them
+	// close the gap but no more, so fast bodies can't pass through thin ones between steps.
+	real speculativeDistance = slop;
+
+	// Polygons are shrunk to a core and surrounded by a skin of this radius, so they collide with
+	// slightly rounded corners. Contacts are generated from the cores, which touching polygons
+	// keep apart by the width of their skins.
+	real polygonRadius = 2 * slop;
+
 	real vRelThreshold = 0.1;
 
 	bool simulSolveVel = true;
@@ -32,7 +44,28 @@ struct PhysicsSettings
 	real muDefault = 0.6;
 	real eDefault = 0.2;
 
-	real aabbFattening = 0.1;
+	// Fat AABBs are enlarged on all sides by a fraction of the body's size, clamped between
+	// aabbMinMargin and aabbMaxMargin, and extended by the displacement predicted over
+	// aabbVelocityMultiplier steps at the current velocity
+	real aabbMarginFraction = 0.25;
+	real aabbMinMargin = 0.02;
+	real aabbMaxMargin = 0.2;
+	real aabbVelocityMultiplier = 4;
+
+	// The broad phase used by Game is chosen when it is constructed
+	BroadphaseType broadphase = BroadphaseType::AABBTree;
+
+	// Cell size for the SpatialHashGrid and Hybrid broad phases.
+	// Ideally a little larger than the fat AABB of a typical small body.
+	real gridCellSize = 0.6;
+
+	// Every treeQualityCheckInterval steps, an AABBTree is rebuilt from scratch if the total
+	// perimeter of its internal nodes exceeds that of a fresh build by more than this ratio
+	int treeQualityCheckInterval = 500;
+	real treeRebuildRatio = 1.3;
+
+	// Collapse the AABBTree into a 4-ary BVH for queries after it changes
+	bool useWideBVH = false;
 
 	// 1 Physics unit = pixPerUnit pixels
 	real pixPerUnit = 120;
@@ -52,4 +85,9 @@ struct PhysicsSettings
 	// Should be considerably less than the slop value, as for persistent contacts 
 	// the separation shouldn't exceed the slop
 	real refEdgeAbsTol = 5e-4;
+
+	// Touching polygons reuse the reference and incident edges from the last full separating axis
+	// test until their relative position or angle has changed by more than these tolerances
+	real satCacheLinearTol = 1e-3;
+	real satCacheAngularTol = 1e-3;
 };
\ No newline at end of file
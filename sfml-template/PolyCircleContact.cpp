@@ -1,10 +1,18 @@
 #include "PolyCircleContact.h"
 
-PolyCircleContact::PolyCircleContact(ConvexPolygon* p, Circle* c, 
-	const vec2& localNormal, const vec2& localRefPoint, Voronoi region, const PhysicsSettings& ps):
-	p(p), c(c), localNormal(localNormal), localRefPoint(localRefPoint), region(region),
-	ContactConstraint(ps, p, c)
+PolyCircleContact::PolyCircleContact(const ContactManifold& m, const PhysicsSettings& ps):
+	p(static_cast<ConvexPolygon*>(m.rb1)), c(static_cast<Circle*>(m.rb2)),
+	ContactConstraint(ps, ContactType::PolyCircle, m.rb1, m.rb2)
 {
+	setFeatures(m);
+}
+
+void PolyCircleContact::setFeatures(const ContactManifold& m)
+{
+	localNormal = m.localNormal;
+	localRefPoint = m.localRefPoint;
+	region = m.region;
+
 	// NOTE: warm starting the rolling friction can cause infinite spinning
 	setRollingFriction();
 }
@@ -12,8 +20,7 @@ PolyCircleContact::PolyCircleContact(ConvexPolygon* p, Circle* c,
 void PolyCircleContact::initPoints()
 {
 	updateNormal();
-	contactPoints.resize(1);
-	rebuildPoint(contactPoints.front());
+	rebuildPoint(addPoint());
 }
 
 void PolyCircleContact::rebuildPoint(ContactPoint& cp)
@@ -21,7 +28,8 @@ void PolyCircleContact::rebuildPoint(ContactPoint& cp)
 	vec2 globalRefPoint = p->pointToGlobal(localRefPoint);
 	vec2 circlePoint = c->furthestPoint(-n);
 
-	cp.penetration = dot(circlePoint - globalRefPoint, n);
+	// The reference point is on the polygon's core, so the skin is taken off
+	cp.penetration = dot(circlePoint - globalRefPoint, n) - p->skinRadius();
 	cp.point = circlePoint - cp.penetration * n;
 }
 
@@ -6,13 +6,13 @@
 class PolyCircleContact : public ContactConstraint
 {
 public:
-	PolyCircleContact(ConvexPolygon* p, Circle* c, const vec2& localNormal, const vec2& localRefPoint, 
-		Voronoi region, const PhysicsSettings& ps);
+	PolyCircleContact(const ContactManifold& m, const PhysicsSettings& ps);
 
 private:
 	void initPoints() override;
 	void rebuildPoint(ContactPoint& cp) override;
 	void updateNormal() override;
+	void setFeatures(const ContactManifold& m) override;
 
 	void setRollingFriction();
 
@@ -1,12 +1,20 @@
 #include "PolyPolyContact.h"
 
-PolyPolyContact::PolyPolyContact(ConvexPolygon* ref, ConvexPolygon* inc, const Edge* refEdge, const Edge* incEdge, const PhysicsSettings& ps):
-	ref(ref), inc(inc),
-	refEdge(refEdge),incEdge(incEdge),
-	ContactConstraint(ps, ref, inc)
+PolyPolyContact::PolyPolyContact(const ContactManifold& m, const PhysicsSettings& ps):
+	ref(static_cast<ConvexPolygon*>(m.rb1)), inc(static_cast<ConvexPolygon*>(m.rb2)),
+	ContactConstraint(ps, ContactType::PolyPoly, m.rb1, m.rb2)
 {
-	localNormal = ref->vecToLocal(refEdge->normal()); 
-	localRefPoint = ref->pointToLocal(refEdge->point1());
+	setFeatures(m);
+}
+
+void PolyPolyContact::setFeatures(const ContactManifold& m)
+{
+	refEdge = m.refEdge;
+	incEdge = m.incEdge;
+	margin = m.margin;
+
+	localNormal = ref->vecToLocal(ref->normal(refEdge)); 
+	localRefPoint = ref->pointToLocal(ref->vertex(refEdge));
 }
 
 //void PolyPolyContact::draw(sf::RenderWindow& window, real pixPerUnit, real fraction, bool debug, sf::Text* text)
@@ -54,52 +62,57 @@ void PolyPolyContact::updateNormal()
 
 void PolyPolyContact::initPoints()
 {
-	contactPoints.reserve(2);
+	vec2 refPoint1 = ref->vertex(refEdge);
+	vec2 refPoint2 = ref->vertex(ref->nextIndex(refEdge));
 
-	vec2 refPoint1 = refEdge->point1();
-	vec2 refPoint2 = refEdge->point2();
-
-	vec2 incPoint1 = incEdge->point1();
-	vec2 incPoint2 = incEdge->point2();
+	vec2 incPoint1 = inc->vertex(incEdge);
+	vec2 incPoint2 = inc->vertex(inc->nextIndex(incEdge));
 
 	ContactPoint cp1, cp2;
-	cp1.incPointIndex = incEdge->v1index();
-	cp1.refEdgeIndex = refEdge->index();
+	cp1.incPointIndex = incEdge;
+	cp1.refEdgeIndex = refEdge;
 	cp1.point = incPoint1;
 
-	cp2.incPointIndex = incEdge->v2index();
-	cp2.refEdgeIndex = refEdge->index();
+	cp2.incPointIndex = inc->nextIndex(incEdge);
+	cp2.refEdgeIndex = refEdge;
 	cp2.point = incPoint2;
 
-	vec2 clipNormal = normalise(refEdge->global());
+	vec2 clipNormal = normalise(ref->edge(refEdge));
 	bool OK1 = clip(-clipNormal, refPoint1, ps.clipPlaneEpsilon, cp1, cp2);
 	bool OK2 = clip(clipNormal, refPoint2, ps.clipPlaneEpsilon, cp1, cp2);
 
 	updateNormal();
-	checkAndAddPoint(cp1, refPoint1, ps.clipPlaneEpsilon);
-	checkAndAddPoint(cp2, refPoint1, ps.clipPlaneEpsilon);
+	checkAndAddPoint(cp1, refPoint1, margin + ps.clipPlaneEpsilon);
+	checkAndAddPoint(cp2, refPoint1, margin + ps.clipPlaneEpsilon);
 }
 
 void PolyPolyContact::rebuildPoint(ContactPoint& cp)
 {
 	vec2 refPoint = ref->pointToGlobal(localRefPoint);
 	cp.point = inc->pointToGlobal(cp.localIncPoint);
-	cp.penetration = dot(cp.point - refPoint, n);
 
-	// Project onto reference edge
-	cp.point -= cp.penetration * n;
+	real coreSeparation = dot(cp.point - refPoint, n);
+	cp.penetration = coreSeparation - ref->skinRadius() - inc->skinRadius();
+
+	// Project onto the surface of the reference polygon's skin
+	cp.point -= (coreSeparation - ref->skinRadius()) * n;
 }
 
-void PolyPolyContact::checkAndAddPoint(ContactPoint& cp, const vec2& ref, real eps)
+void PolyPolyContact::checkAndAddPoint(const ContactPoint& cp, const vec2& ref, real eps)
 {
-	// If cp lies inside the reference edge, store its penetration, project it into the edge, 
-	// and add it to the contactPoints vector.
+	// If the skins around cp and the reference edge overlap, or are less than eps apart, add cp
+	// to the contact points, store its penetration, and project it onto the reference skin.
+	// cp and ref are points on the cores.
+
+	real coreSeparation = dot(cp.point - ref, n);
+	real penetration = coreSeparation - this->ref->skinRadius() - inc->skinRadius();
 
-	cp.penetration = dot(cp.point - ref, n);
-	if (cp.penetration <= eps)
+	if (penetration <= eps)
 	{
-		cp.localIncPoint = inc->pointToLocal(cp.point);
-		cp.point -= cp.penetration * n;
-		contactPoints.push_back(cp);
+		ContactPoint& added = addPoint();
+		added = cp;
+		added.penetration = penetration;
+		added.localIncPoint = inc->pointToLocal(cp.point);
+		added.point -= (coreSeparation - this->ref->skinRadius()) * n;
 	}
 }
\ No newline at end of file
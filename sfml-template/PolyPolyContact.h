@@ -2,28 +2,29 @@
 #include "ContactConstraint.h"
 #include "ContactPoint.h"
 #include "ConvexPolygon.h"
-#include "Edge.h"
 
 class PolyPolyContact : public ContactConstraint
 {
 public:
-	PolyPolyContact(ConvexPolygon* ref, ConvexPolygon* inc, const Edge* refEdge, const Edge* incEdge, const PhysicsSettings& ps);
+	PolyPolyContact(const ContactManifold& m, const PhysicsSettings& ps);
 
 private:
 	void initPoints() override;
 	void rebuildPoint(ContactPoint& cp) override;
 	void updateNormal() override;
+	void setFeatures(const ContactManifold& m) override;
 
 	const ConvexPolygon* const ref;
 	const ConvexPolygon* const inc;
 
 	// Store incident and reference edges for use in initPoints
-	const Edge* refEdge = nullptr;
-	const Edge* incEdge = nullptr;
+	int refEdge = 0;
+	int incEdge = 0;
+	real margin = 0;
 
 	vec2 localNormal;
 	vec2 localRefPoint;
 
-	void checkAndAddPoint(ContactPoint& cp, const vec2& ref, real eps);
+	void checkAndAddPoint(const ContactPoint& cp, const vec2& ref, real eps);
 };
 
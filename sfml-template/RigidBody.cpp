@@ -1,9 +1,10 @@
 #include "RigidBody.h"
 #include "AABBTree.h"
 #include "Constraint.h"
+#include <algorithm>
 
-RigidBody::RigidBody(const PhysicsSettings& ps, real mInv, real IInv):
-	ps(ps), m_mInv(mInv), m_IInv(IInv),
+RigidBody::RigidBody(const PhysicsSettings& ps, Shape shape, real mInv, real IInv):
+	ps(ps), mShape(shape), m_mInv(mInv), m_IInv(IInv),
 	id(counter++)
 {
 	
@@ -84,6 +85,43 @@ real RigidBody::interpolateAngle(real fraction) const
 	return std::atan2(dirInterp.y, dirInterp.x);
 }
 
+void RigidBody::updateFatAABB()
+{
+	aabbFat = aabb;
+
+	// Static bodies never move, so don't need any margin
+	if (isStatic())
+	{
+		return;
+	}
+
+	vec2 size = aabb.upper - aabb.lower;
+	real margin = std::clamp(ps.aabbMarginFraction * std::max(size.x, size.y), ps.aabbMinMargin, ps.aabbMaxMargin);
+
+	aabbFat.lower -= { margin, margin };
+	aabbFat.upper += { margin, margin };
+
+	vec2 d = vel * ps.dt * ps.aabbVelocityMultiplier;
+
+	(d.x < 0 ? aabbFat.lower.x : aabbFat.upper.x) += d.x;
+	(d.y < 0 ? aabbFat.lower.y : aabbFat.upper.y) += d.y;
+}
+
+real RigidBody::maxStepDisplacement() const
+{
+	// Every point lies within the AABB, so no point is further from the centre than the furthest corner
+	vec2 halfSize = static_cast<real>(0.5) * (aabb.upper - aabb.lower);
+	vec2 offset = static_cast<real>(0.5) * (aabb.upper + aabb.lower) - pos;
+	real maxRadius = magnitude({ std::abs(offset.x) + halfSize.x, std::abs(offset.y) + halfSize.y });
+
+	return (magnitude(vel) + std::abs(omega) * maxRadius) * ps.dt;
+}
+
+real RigidBody::speculativeMargin(const RigidBody* other) const
+{
+	return ps.speculativeDistance + maxStepDisplacement() + other->maxStepDisplacement();
+}
+
 void RigidBody::applyDeltaVel(const vec2& dv, real dw)
 {
 	vel += dv;
@@ -104,6 +142,10 @@ void RigidBody::applyDeltaPos(const vec2& dr, real dth, bool update)
 	{
 		onMove();
 	}
+	else
+	{
+		updateChildPoses();
+	}
 }
 
 
@@ -132,6 +174,12 @@ bool RigidBody::canCollideWith(const RigidBody* other) const
 {
 	// TODO: store a separate list of individual RBs that are forbidden?
 
+	// Shapes in the same compound can't move relative to each other
+	if (body() == other->body())
+	{
+		return false;
+	}
+
 	bool wantsToCollide = other->ownTypes & this->collidableTypes;
 	bool otherWantsToCollide = this->ownTypes & other->collidableTypes;
 
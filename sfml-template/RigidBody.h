@@ -5,6 +5,8 @@
 #include "Constraint.h"
 #include "PhysicsSettings.h"
 #include "AABB.h"
+#include "PairCache.h"
+#include "ContactManifold.h"
 
 class ConvexPolygon;
 class Circle;
@@ -15,6 +17,10 @@ using idType = uint64_t;
 using idPair = std::pair<idType, idType>;
 using collType = uint16_t; 
 
+// Concrete type of a RigidBody, used to pick a collision function.
+// Compound bodies never collide themselves (their children do), so they come after Count.
+enum class Shape : uint8_t { Polygon, Circle, Count, Compound };
+
 struct idPairHasher
 {
 	size_t operator() (const idPair& p) const
@@ -27,18 +33,32 @@ struct idPairHasher
 class RigidBody
 {
 public:
-	RigidBody(const PhysicsSettings& ps, real mInv = 0, real IInv = 0);
+	RigidBody(const PhysicsSettings& ps, Shape shape, real mInv = 0, real IInv = 0);
 
 	virtual void draw(sf::RenderWindow& window, real fraction, 
 		bool debug = false, sf::Text* text = nullptr) = 0;
 
-	virtual std::unique_ptr<ContactConstraint> checkCollision(RigidBody* other) = 0;
-	virtual std::unique_ptr<ContactConstraint> checkCollision(ConvexPolygon* other) = 0;
-	virtual std::unique_ptr<ContactConstraint> checkCollision(Circle* other) = 0;
+	Shape shape() const { return mShape; }
+	bool isCompound() const { return mShape == Shape::Compound; }
+
+	// A body in a compound doesn't move by itself, but keeps a fixed pose relative to the compound,
+	// which takes the impulses from its contacts. body() is the compound, or this body if it isn't in one.
+	bool inCompound() const { return owner != nullptr; }
+	RigidBody* body() { return owner ? owner : this; }
+	const RigidBody* body() const { return owner ? owner : this; }
 
 	virtual bool pointInside(const vec2& p) const = 0;
 	virtual void updateAABB() = 0;
-	virtual void updateFatAABB() = 0;
+
+	// Enlarge the current AABB by a margin based on the body's size,
+	// and extend it along the displacement predicted from its velocity
+	void updateFatAABB();
+
+	// Upper bound on how far any point of the body moves during one step at its current velocity
+	real maxStepDisplacement() const;
+
+	// Separation below which the narrow phase reports a (possibly speculative) contact with other
+	real speculativeMargin(const RigidBody* other) const;
 
 	vec2 pointToLocal(const vec2& p) const;
 	vec2 pointToGlobal(const vec2& p) const;
@@ -90,15 +110,34 @@ public:
 	void setmInv(real mInv) { m_mInv = mInv; } 
 	void setIInv(real IInv) { m_IInv = IInv; }
 
+	// A static body can neither translate nor rotate, so its AABB never changes
+	bool isStatic() const { return m_mInv == 0 && m_IInv == 0; }
+
 	void setRefPoint(const vec2& ref) { refPoint = ref; }
 	vec2 getRefPoint() const { return refPoint; }
 
 	bool canCollideWith(const RigidBody* other) const;
+
+	// Could a body of this one's types collide with anything in a group whose
+	// combined (OR-ed) types and collidable types are given?
+	bool canCollideWithGroup(collType types, collType collidables) const
+	{
+		return (types & collidableTypes) && (ownTypes & collidables);
+	}
+
+	// If the body is already in a broad phase, call Broadphase::refreshFilter() after changing these
 	void setCollType(collType t) { ownTypes = t; }
 	void setCollidables(collType t) { collidableTypes = t; }
+	collType collTypes() const { return ownTypes; }
+	collType collidables() const { return collidableTypes; }
 
 	// real KE() const { return 0.5 * dot(vel, vel) / m_mInv; }
 
+	// Index of this body's proxy within the broad phase structure that holds it, or -1.
+	// NOTE: these should only be called by the Broadphase classes
+	int proxyIndex() const { return proxy; }
+	void setProxyIndex(int p) { proxy = p; }
+
 	// NOTE: these should only be called by the Constraint class
 	void addConstraintToList(Constraint* c) { constraints.insert(c); }
 	void removeConstraintFromList(Constraint* c) { constraints.erase(c); }
@@ -109,9 +148,17 @@ protected:
 	const PhysicsSettings& ps;
 	AABB aabb, aabbFat;
 
+	// Called by applyDeltaPos() when onMove() isn't, so that bodies which follow this one can
+	// keep their poses up to date
+	virtual void updateChildPoses() { }
+
 private:
+	friend class CompoundBody;
+
 	void markConstraintsForRemoval();
 
+	const Shape mShape;
+
 	real m_mInv = 0, m_IInv = 0;
 
 	vec2 pos, vel, acc;
@@ -125,6 +172,13 @@ private:
 
 	vec2 refPoint = {0, 0};
 
+	int proxy = -1;
+
+	// The compound this body belongs to, if any, and its pose in the compound's local coordinates
+	RigidBody* owner = nullptr;
+	vec2 compoundPos;
+	real compoundAngle = 0;
+
 	// By default, a RigidBody belongs to type 1 and can collide with any type
 	collType ownTypes = 1;
 	collType collidableTypes = std::numeric_limits<collType>::max();
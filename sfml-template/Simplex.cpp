@@ -8,8 +8,6 @@ std::tuple<vec2, vec2, Voronoi> Simplex::closestPoint(const vec2& point)
     // The sign of a 2-point barycentric coordinate doesn't depend on whether the division
     // has taken place, but for a 3-point coordinate it does.
 
-    int npoints = vertices.size();
-
     vec2 pA = vertices[0].coords();
 
     if (npoints == 1)
@@ -131,25 +129,31 @@ std::tuple<vec2, vec2, Voronoi> Simplex::closestPoint(const vec2& point)
     }
 }
 
-void Simplex::addVertex(const Vertex* vertex)
+void Simplex::addVertex(int index, const vec2& coords)
 {
-    vertices.push_back(vertex);
+    vertices[npoints++] = SimplexVertex(index, coords);
 }
 
 void Simplex::cleanupVertices()
 {
-    std::erase_if(vertices, [](const SimplexVertex& v) { return v.removeFlagSet(); });
+    auto end = std::remove_if(vertices.begin(), vertices.begin() + npoints, [](const SimplexVertex& v) { return v.removeFlagSet(); });
+    npoints = end - vertices.begin();
 }
 
-bool Simplex::contains(const Vertex* vertex) const
+bool Simplex::contains(int index) const
 {
-    for (const SimplexVertex& v : vertices)
+    for (int i = 0; i < npoints; ++i)
     {
-        if (v.matches(vertex))
+        if (vertices[i].matches(index))
         {
             return true;
         }
     }
 
     return false;
+}
+
+int Simplex::index(int i) const
+{
+    return vertices[i].polygonIndex();
 }
\ No newline at end of file
@@ -1,34 +1,41 @@
 #pragma once
 
-#include "Vertex.h"
+#include "Utils.h"
 
 class Simplex
 {
 public:
 	std::tuple<vec2, vec2, Voronoi> closestPoint(const vec2& point);
 	
-	bool contains(const Vertex* vertex) const;
-	void addVertex(const Vertex* vertex);
+	// Vertices are identified by their index in the polygon
+	bool contains(int index) const;
+	void addVertex(int index, const vec2& coords);
 	void cleanupVertices();
 
+	int size() const { return npoints; }
+	int index(int i) const;
+
 private:
-	class SimplexVertex;
-	std::vector<SimplexVertex> vertices;
-};
+	class SimplexVertex
+	{
+	public:
+		SimplexVertex() = default;
+		SimplexVertex(int index, const vec2& coords) : index(index), point(coords) { };
+		vec2 coords() const { return point; }
+		int polygonIndex() const { return index; }
 
+		void markForRemoval() { remove = true; }
+		void unsetRemoveFlag() { remove = false; }
+		bool removeFlagSet() const { return remove; }
+		bool matches(int i) const { return i == index; }
 
-class Simplex::SimplexVertex
-{
-public:
-	SimplexVertex(const Vertex* v) : vertex(v) { };
-	vec2 coords() const { return vertex->global(); }
+	private:
+		int index = 0;
+		vec2 point;
+		bool remove = false;
+	};
 
-	void markForRemoval() { remove = true; }
-	void unsetRemoveFlag() { remove = false; }
-	bool removeFlagSet() const { return remove; }
-	bool matches(const Vertex* v) const { return v == vertex; }
-
-private:
-	const Vertex* vertex = nullptr;
-	bool remove = false;
+	// A 2D simplex never has more than three vertices, so they're stored inline
+	std::array<SimplexVertex, 3> vertices;
+	int npoints = 0;
 };
\ No newline at end of file
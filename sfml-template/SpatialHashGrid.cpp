@@ -0,0 +1,164 @@
+#include "SpatialHashGrid.h"
+
+SpatialHashGrid::SpatialHashGrid(real cellSize):
+	cellSize(cellSize)
+{
+	rect.setOutlineColor(sf::Color::Black);
+	rect.setOutlineThickness(1);
+	rect.setFillColor(sf::Color::Transparent);
+}
+
+void SpatialHashGrid::insert(RigidBody* rb)
+{
+	assert(rb->proxyIndex() == -1 && "Body already has a proxy in another broad phase");
+
+	if (freeList == -1)
+	{
+		proxies.emplace_back();
+		freeList = proxies.size() - 1;
+	}
+
+	int proxy = freeList;
+	freeList = proxies[proxy].next;
+
+	proxies[proxy] = Proxy{ rb, rb->getFatAABB(), cellRange(rb->getFatAABB()) };
+	rb->setProxyIndex(proxy);
+	++proxyCount;
+
+	addToCells(proxy);
+
+	moveBuffer.push_back(rb);
+}
+
+void SpatialHashGrid::remove(RigidBody* rb)
+{
+	int proxy = rb->proxyIndex();
+	rb->setProxyIndex(-1);
+	--proxyCount;
+
+	removeFromCells(proxy);
+
+	proxies[proxy] = Proxy{};
+	proxies[proxy].next = freeList;
+	freeList = proxy;
+
+	std::erase(moveBuffer, rb);
+	removePairs(rb);
+}
+
+void SpatialHashGrid::update(RigidBody* rb)
+{
+	int proxy = rb->proxyIndex();
+	if (proxies[proxy].aabb.contains(rb->getAABB()))
+	{
+		return;
+	}
+
+	rb->updateFatAABB();
+
+	CellRange newCells = cellRange(rb->getFatAABB());
+	const CellRange& oldCells = proxies[proxy].cells;
+
+	bool sameCells = newCells.x0 == oldCells.x0 && newCells.y0 == oldCells.y0
+		&& newCells.x1 == oldCells.x1 && newCells.y1 == oldCells.y1;
+
+	if (!sameCells)
+	{
+		removeFromCells(proxy);
+		proxies[proxy].cells = newCells;
+		addToCells(proxy);
+	}
+
+	proxies[proxy].aabb = rb->getFatAABB();
+
+	moveBuffer.push_back(rb);
+	++reinserts;
+}
+
+bool SpatialHashGrid::holds(const RigidBody* rb) const
+{
+	int proxy = rb->proxyIndex();
+	return proxy >= 0 && proxy < static_cast<int>(proxies.size()) && proxies[proxy].rb == rb;
+}
+
+void SpatialHashGrid::updatePairs()
+{
+	addPairsForMoved([this](RigidBody* rb, std::vector<ProxyPair>& result)
+	{
+		query(rb->getFatAABB(), [&](RigidBody* other)
+		{
+			if (other != rb)
+			{
+				result.push_back({ rb, other });
+			}
+		}, rb);
+	});
+}
+
+void SpatialHashGrid::draw(sf::RenderWindow& window, real pixPerUnit)
+{
+	// Draw the occupied cells
+	rect.setSize(sf::Vector2f(cellSize * pixPerUnit, cellSize * pixPerUnit));
+
+	for (const auto& [key, cell] : cells)
+	{
+		if (cell.empty())
+		{
+			continue;
+		}
+
+		int x = static_cast<int32_t>(key >> 32);
+		int y = static_cast<int32_t>(key & 0xffffffff);
+
+		rect.setPosition(x * cellSize * pixPerUnit, y * cellSize * pixPerUnit);
+		window.draw(rect);
+	}
+}
+
+SpatialHashGrid::CellRange SpatialHashGrid::cellRange(const AABB& aabb) const
+{
+	CellRange range;
+
+	range.x0 = static_cast<int>(std::floor(aabb.lower.x / cellSize));
+	range.y0 = static_cast<int>(std::floor(aabb.lower.y / cellSize));
+	range.x1 = static_cast<int>(std::floor(aabb.upper.x / cellSize));
+	range.y1 = static_cast<int>(std::floor(aabb.upper.y / cellSize));
+
+	return range;
+}
+
+uint64_t SpatialHashGrid::cellKey(int x, int y)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+void SpatialHashGrid::addToCells(int proxy)
+{
+	const CellRange& range = proxies[proxy].cells;
+
+	for (int x = range.x0; x <= range.x1; ++x)
+	{
+		for (int y = range.y0; y <= range.y1; ++y)
+		{
+			cells[cellKey(x, y)].push_back(proxy);
+		}
+	}
+}
+
+void SpatialHashGrid::removeFromCells(int proxy)
+{
+	const CellRange& range = proxies[proxy].cells;
+
+	for (int x = range.x0; x <= range.x1; ++x)
+	{
+		for (int y = range.y0; y <= range.y1; ++y)
+		{
+			// Order within a cell doesn't matter, so swap with the back and pop
+			std::vector<int>& cell = cells[cellKey(x, y)];
+			auto it = std::find(cell.begin(), cell.end(), proxy);
+
+			*it = cell.back();
+			cell.pop_back();
+		}
+	}
+}
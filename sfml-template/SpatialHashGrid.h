@@ -0,0 +1,106 @@
+#pragma once
+#include "Utils.h"
+#include "RigidBody.h"
+#include "Broadphase.h"
+#include <unordered_map>
+
+// Uniform grid of square cells, stored sparsely in a hash map keyed on the cell coordinates.
+// Each proxy is registered in every cell its fat AABB touches, so this works best when all
+// bodies are of similar size and not much larger than a cell. For large or static bodies,
+// see HybridBroadphase.
+class SpatialHashGrid : public Broadphase
+{
+public:
+	SpatialHashGrid(real cellSize);
+
+	void insert(RigidBody* rb) override;
+	void remove(RigidBody* rb) override;
+	void update(RigidBody* rb) override;
+
+	void updatePairs() override;
+
+	// Calls callback(rb) once for every proxy whose fat AABB overlaps aabb,
+	// skipping any that filter can't collide with, if given
+	template <typename F>
+	void query(const AABB& aabb, F&& callback, const RigidBody* filter = nullptr) const;
+
+	void queryAABB(const AABB& aabb, QueryCallback callback) const override { query(aabb, callback); }
+	void queryPoint(const vec2& p, QueryCallback callback) const override { query({ p, p }, callback); }
+
+	void draw(sf::RenderWindow& window, real pixPerUnit) override;
+
+	int count() const override { return proxyCount; }
+
+	// Is rb held by this grid, as opposed to some other structure?
+	bool holds(const RigidBody* rb) const;
+
+private:
+	struct CellRange
+	{
+		int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+	};
+
+	struct Proxy
+	{
+		RigidBody* rb = nullptr;
+		AABB aabb;
+		CellRange cells;
+
+		// Index of the next free proxy, for proxies in the free list
+		int next = -1;
+	};
+
+	CellRange cellRange(const AABB& aabb) const;
+	static uint64_t cellKey(int x, int y);
+
+	void addToCells(int proxy);
+	void removeFromCells(int proxy);
+
+	const real cellSize;
+
+	std::vector<Proxy> proxies;
+	int freeList = -1;
+
+	int proxyCount = 0;
+
+	// Indices of the proxies touching each cell. Cells are not erased when they become
+	// empty, to avoid reallocating them as bodies move back and forth.
+	std::unordered_map<uint64_t, std::vector<int>> cells;
+
+	sf::RectangleShape rect;
+};
+
+template <typename F>
+void SpatialHashGrid::query(const AABB& aabb, F&& callback, const RigidBody* filter) const
+{
+	CellRange range = cellRange(aabb);
+
+	for (int x = range.x0; x <= range.x1; ++x)
+	{
+		for (int y = range.y0; y <= range.y1; ++y)
+		{
+			auto it = cells.find(cellKey(x, y));
+			if (it == cells.end())
+			{
+				continue;
+			}
+
+			for (int i : it->second)
+			{
+				const Proxy& p = proxies[i];
+
+				// A proxy spanning several cells is only reported from the first cell
+				// shared with the query range, so no list of visited proxies is needed
+				if (x != std::max(range.x0, p.cells.x0) || y != std::max(range.y0, p.cells.y0))
+				{
+					continue;
+				}
+
+				if (p.aabb.overlaps(aabb) && (!filter || filter->canCollideWith(p.rb)))
+				{
+					callback(p.rb);
+				}
+			}
+		}
+	}
+}
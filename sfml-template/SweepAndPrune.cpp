@@ -0,0 +1,117 @@
+#include "SweepAndPrune.h"
+
+SweepAndPrune::SweepAndPrune()
+{
+	rect.setOutlineColor(sf::Color::Black);
+	rect.setOutlineThickness(1);
+	rect.setFillColor(sf::Color::Transparent);
+}
+
+void SweepAndPrune::insert(RigidBody* rb)
+{
+	// The new proxy will be moved into place by the next sort
+	proxies.push_back({ rb->getFatAABB(), rb });
+}
+
+void SweepAndPrune::remove(RigidBody* rb)
+{
+	// Erasing (rather than swapping with the back) keeps the list sorted
+	std::erase_if(proxies, [rb](const Proxy& p) { return p.rb == rb; });
+	std::erase(moveBuffer, rb);
+	removePairs(rb);
+}
+
+void SweepAndPrune::update(RigidBody* rb)
+{
+	// The proxy's copy of the fat AABB is refreshed in updatePairs()
+	if (!rb->getFatAABB().contains(rb->getAABB()))
+	{
+		rb->updateFatAABB();
+		++reinserts;
+	}
+}
+
+void SweepAndPrune::updatePairs()
+{
+	for (Proxy& p : proxies)
+	{
+		p.aabb = p.rb->getFatAABB();
+	}
+
+	sortProxies();
+
+	removeStalePairs();
+
+	// Every proxy that starts before proxy i ends is a candidate along x,
+	// so only the y ranges still need to be checked
+	int n = proxies.size();
+	for (int i = 0; i < n; ++i)
+	{
+		const AABB& a = proxies[i].aabb;
+
+		for (int j = i + 1; j < n && proxies[j].aabb.lower.x <= a.upper.x; ++j)
+		{
+			const AABB& b = proxies[j].aabb;
+
+			if (rangeOverlaps({ a.lower.y, a.upper.y }, { b.lower.y, b.upper.y }) && proxies[i].rb->canCollideWith(proxies[j].rb))
+			{
+				addPair(proxies[i].rb, proxies[j].rb);
+			}
+		}
+	}
+}
+
+void SweepAndPrune::queryAABB(const AABB& aabb, QueryCallback callback) const
+{
+	for (const Proxy& proxy : proxies)
+	{
+		if (proxy.aabb.lower.x > aabb.upper.x)
+		{
+			// No later proxy can overlap aabb
+			break;
+		}
+
+		if (proxy.aabb.overlaps(aabb))
+		{
+			callback(proxy.rb);
+		}
+	}
+}
+
+void SweepAndPrune::queryPoint(const vec2& p, QueryCallback callback) const
+{
+	queryAABB({ p, p }, callback);
+}
+
+void SweepAndPrune::draw(sf::RenderWindow& window, real pixPerUnit)
+{
+	for (const Proxy& p : proxies)
+	{
+		rect.setPosition(p.aabb.lower.x * pixPerUnit, p.aabb.lower.y * pixPerUnit);
+
+		vec2 size = p.aabb.upper - p.aabb.lower;
+
+		rect.setSize(sf::Vector2f(size.x * pixPerUnit, size.y * pixPerUnit));
+
+		window.draw(rect);
+	}
+}
+
+void SweepAndPrune::sortProxies()
+{
+	// Insertion sort on the lower x bound
+	int n = static_cast<int>(proxies.size());
+	for (int i = 1; i < n; ++i)
+	{
+		Proxy key = proxies[i];
+		int j = i - 1;
+
+		while (j >= 0 && proxies[j].aabb.lower.x > key.aabb.lower.x)
+		{
+			proxies[j + 1] = proxies[j];
+			--j;
+		}
+
+		proxies[j + 1] = key;
+	}
+}
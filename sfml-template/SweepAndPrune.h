@@ -0,0 +1,43 @@
+#pragma once
+#include "Utils.h"
+#include "RigidBody.h"
+#include "Broadphase.h"
+
+// Sorts the fat AABBs along the x axis and sweeps the sorted list to find overlaps.
+// An insertion sort is used, which is close to linear when bodies only move a little
+// between steps. Works best when bodies are spread out along x.
+class SweepAndPrune : public Broadphase
+{
+public:
+	SweepAndPrune();
+
+	void insert(RigidBody* rb) override;
+	void remove(RigidBody* rb) override;
+	void update(RigidBody* rb) override;
+
+	// Every step is a full sweep, so there is nothing to refresh
+	void refreshFilter(RigidBody*) override { }
+
+	void updatePairs() override;
+
+	void queryAABB(const AABB& aabb, QueryCallback callback) const override;
+	void queryPoint(const vec2& p, QueryCallback callback) const override;
+
+	void draw(sf::RenderWindow& window, real pixPerUnit) override;
+
+	int count() const override { return proxies.size(); }
+
+private:
+	struct Proxy
+	{
+		AABB aabb;
+		RigidBody* rb = nullptr;
+	};
+
+	void sortProxies();
+
+	// Kept sorted by aabb.lower.x after each call to updatePairs()
+	std::vector<Proxy> proxies;
+
+	sf::RectangleShape rect;
+};
@@ -155,6 +155,23 @@ real decayConstant(real halfLife)
 	return std::log(2) / halfLife;
 }
 
+const std::vector<int>& workerIndices()
+{
+	static const std::vector<int> indices = []()
+	{
+		std::vector<int> result(std::max(std::thread::hardware_concurrency(), 1u));
+		std::iota(result.begin(), result.end(), 0);
+		return result;
+	}();
+
+	return indices;
+}
+
+std::pair<int, int> chunkRange(int n, int chunk, int nChunks)
+{
+	return { n * chunk / nChunks, n * (chunk + 1) / nChunks };
+}
+
 void drawLine(sf::RenderWindow& window, const vec2& p1, const vec2& p2, sf::Color col)
 {
 	sf::Vertex line[] = {
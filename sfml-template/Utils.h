@@ -18,6 +18,8 @@
 #include <execution>
 #include <forward_list>
 #include <initializer_list>
+#include <thread>
+#include <numeric>
 
 
 struct ContactPoint;
@@ -60,6 +62,14 @@ bool rangeContains(const std::pair<real, real>& R, real x);
 
 real decayConstant(real halfLife);
 
+// Indices 0, 1, ..., nWorkers - 1, with one worker per hardware thread.
+// Iterate over these with std::execution::par and use chunkRange() to divide up the work.
+const std::vector<int>& workerIndices();
+
+// Returns the half-open range [begin, end) of the given chunk when n items are
+// split into nChunks contiguous chunks of near-equal size
+std::pair<int, int> chunkRange(int n, int chunk, int nChunks);
+
 void drawLine(sf::RenderWindow& window, const vec2& p1, const vec2& p2, sf::Color col);
 void drawThickLine(sf::RenderWindow& window, const vec2& p1, const vec2& p2, real width, sf::Color col);
 
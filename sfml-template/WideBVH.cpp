@@ -0,0 +1,189 @@
+#include "WideBVH.h"
+#include "AABBTree.h"
+
+int WideBVH::collapse(const AABBTree& tree, int binaryRoot)
+{
+	if (binaryRoot == AABBTree::nullNode)
+	{
+		return nullNode;
+	}
+
+	// Gather up to four descendants of the binary node, by repeatedly opening
+	// the internal node with the largest perimeter
+	int binaryChildren[width];
+	int count = 0;
+
+	const AABBTree::Node& top = tree.nodes[binaryRoot];
+
+	if (top.isLeaf())
+	{
+		// Only possible for a tree with one proxy
+		binaryChildren[count++] = binaryRoot;
+	}
+	else
+	{
+		binaryChildren[count++] = top.child1;
+		binaryChildren[count++] = top.child2;
+	}
+
+	while (count < width)
+	{
+		int best = -1;
+		real bestPeri = 0;
+
+		for (int i = 0; i < count; ++i)
+		{
+			const AABBTree::Node& c = tree.nodes[binaryChildren[i]];
+			if (!c.isLeaf() && (best == -1 || c.aabb.peri() > bestPeri))
+			{
+				best = i;
+				bestPeri = c.aabb.peri();
+			}
+		}
+
+		if (best == -1)
+		{
+			break;
+		}
+
+		const AABBTree::Node& opened = tree.nodes[binaryChildren[best]];
+		binaryChildren[best] = opened.child1;
+		binaryChildren[count++] = opened.child2;
+	}
+
+	int w = nodes.size();
+	nodes.emplace_back();
+
+	for (int i = 0; i < width; ++i)
+	{
+		// Unused slots are given inverted bounds, so never overlap anything
+		AABB bounds = { { 1e30f, 1e30f }, { -1e30f, -1e30f } };
+		int ref = nullNode;
+		collType types = 0;
+		collType collidables = 0;
+
+		if (i < count)
+		{
+			const AABBTree::Node& c = tree.nodes[binaryChildren[i]];
+			bounds = c.aabb;
+			types = c.types;
+			collidables = c.collidables;
+
+			if (c.isLeaf())
+			{
+				leaves.push_back(c.rb);
+				ref = ~int(leaves.size() - 1);
+			}
+			else
+			{
+				// nodes may be reallocated here, so w is used rather than a reference
+				ref = collapse(tree, binaryChildren[i]);
+			}
+		}
+
+		Node& n = nodes[w];
+		n.minX[i] = bounds.lower.x;
+		n.minY[i] = bounds.lower.y;
+		n.maxX[i] = bounds.upper.x;
+		n.maxY[i] = bounds.upper.y;
+		n.children[i] = ref;
+		n.types[i] = types;
+		n.collidables[i] = collidables;
+	}
+
+	nodes[w].count = count;
+
+	return w;
+}
+
+void WideBVH::clear()
+{
+	nodes.clear();
+	leaves.clear();
+}
+
+int WideBVH::overlapMask(const Node& n, const AABB& aabb) const
+{
+#ifdef WIDE_BVH_SSE
+	__m128 overlapX = _mm_and_ps(
+		_mm_cmple_ps(_mm_load_ps(n.minX), _mm_set1_ps(aabb.upper.x)),
+		_mm_cmpge_ps(_mm_load_ps(n.maxX), _mm_set1_ps(aabb.lower.x)));
+
+	__m128 overlapY = _mm_and_ps(
+		_mm_cmple_ps(_mm_load_ps(n.minY), _mm_set1_ps(aabb.upper.y)),
+		_mm_cmpge_ps(_mm_load_ps(n.maxY), _mm_set1_ps(aabb.lower.y)));
+
+	return _mm_movemask_ps(_mm_and_ps(overlapX, overlapY)) & ((1 << n.count) - 1);
+#else
+	int mask = 0;
+
+	for (int i = 0; i < n.count; ++i)
+	{
+		if (n.minX[i] <= aabb.upper.x && n.maxX[i] >= aabb.lower.x
+			&& n.minY[i] <= aabb.upper.y && n.maxY[i] >= aabb.lower.y)
+		{
+			mask |= 1 << i;
+		}
+	}
+
+	return mask;
+#endif
+}
+
+int WideBVH::filterMask(const Node& n, const RigidBody* filter) const
+{
+	int mask = 0;
+
+	for (int i = 0; i < n.count; ++i)
+	{
+		if (filter->canCollideWithGroup(n.types[i], n.collidables[i]))
+		{
+			mask |= 1 << i;
+		}
+	}
+
+	return mask;
+}
+
+int WideBVH::castMask(const Node& n, const vec2& p, const vec2& invD, const vec2& halfExtents, real maxFraction) const
+{
+#ifdef WIDE_BVH_SSE
+	// Slab test, with the bounds enlarged by halfExtents
+	__m128 px = _mm_set1_ps(p.x);
+	__m128 py = _mm_set1_ps(p.y);
+	__m128 invDx = _mm_set1_ps(invD.x);
+	__m128 invDy = _mm_set1_ps(invD.y);
+	__m128 hx = _mm_set1_ps(halfExtents.x);
+	__m128 hy = _mm_set1_ps(halfExtents.y);
+
+	__m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_load_ps(n.minX), hx), px), invDx);
+	__m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_load_ps(n.maxX), hx), px), invDx);
+	__m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_load_ps(n.minY), hy), py), invDy);
+	__m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_load_ps(n.maxY), hy), py), invDy);
+
+	__m128 tMin = _mm_max_ps(_mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y)), _mm_setzero_ps());
+	__m128 tMax = _mm_min_ps(_mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y)), _mm_set1_ps(maxFraction));
+
+	return _mm_movemask_ps(_mm_cmple_ps(tMin, tMax)) & ((1 << n.count) - 1);
+#else
+	int mask = 0;
+
+	for (int i = 0; i < n.count; ++i)
+	{
+		real t1x = (n.minX[i] - halfExtents.x - p.x) * invD.x;
+		real t2x = (n.maxX[i] + halfExtents.x - p.x) * invD.x;
+		real t1y = (n.minY[i] - halfExtents.y - p.y) * invD.y;
+		real t2y = (n.maxY[i] + halfExtents.y - p.y) * invD.y;
+
+		real tMin = std::max({ std::min(t1x, t2x), std::min(t1y, t2y), real(0) });
+		real tMax = std::min({ std::max(t1x, t2x), std::max(t1y, t2y), maxFraction });
+
+		if (tMin <= tMax)
+		{
+			mask |= 1 << i;
+		}
+	}
+
+	return mask;
+#endif
+}
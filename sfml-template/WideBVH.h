@@ -0,0 +1,153 @@
+#pragma once
+#include "Utils.h"
+#include "AABB.h"
+#include "RigidBody.h"
+#include "NodeStack.h"
+#include <bit>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define WIDE_BVH_SSE
+#include <xmmintrin.h>
+static_assert(std::is_same_v<real, float>, "The SSE path of WideBVH assumes single precision");
+#endif
+
+class AABBTree;
+
+// A 4-ary BVH collapsed from the binary AABBTree. Each node stores the bounds of its children
+// in structure-of-arrays form, so that all four can be tested with a single SSE comparison.
+// It has no incremental updates of its own, and is simply rebuilt after the binary tree changes.
+class WideBVH
+{
+public:
+	// Collapse the binary subtree with the given root, and return the root of the new wide
+	// subtree. Several subtrees can be collapsed into the same WideBVH after calling clear().
+	int collapse(const AABBTree& tree, int binaryRoot);
+	void clear();
+
+	// Calls callback(rb) for every leaf whose AABB overlaps aabb. If filter is given,
+	// children containing nothing that filter can collide with are skipped.
+	template <typename F>
+	void query(int root, const AABB& aabb, F&& callback, const RigidBody* filter = nullptr) const;
+
+	// Visits the leaves hit by the segment from p to p + maxFraction * d, with each AABB
+	// enlarged by halfExtents. onLeaf(rb) returns the new max fraction, and zero ends the cast.
+	template <typename F>
+	void cast(int root, const vec2& p, const vec2& d, const vec2& halfExtents, real maxFraction, F&& onLeaf) const;
+
+	static constexpr int width = 4;
+	static constexpr int nullNode = -1;
+
+private:
+	// Child references are node indices for internal nodes, or ~leafIndex (always negative) for leaves
+	static bool isLeafRef(int ref) { return ref < 0; }
+	static int leafIndex(int ref) { return ~ref; }
+
+	struct Node
+	{
+		alignas(16) real minX[width];
+		alignas(16) real minY[width];
+		alignas(16) real maxX[width];
+		alignas(16) real maxY[width];
+
+		int children[width];
+		int count = 0;
+
+		// OR of the collision types and collidable types within each child
+		collType types[width];
+		collType collidables[width];
+	};
+
+	// Bitmask of the children of n whose bounds overlap aabb, or are hit by the segment
+	int overlapMask(const Node& n, const AABB& aabb) const;
+	int filterMask(const Node& n, const RigidBody* filter) const;
+	int castMask(const Node& n, const vec2& p, const vec2& invD, const vec2& halfExtents, real maxFraction) const;
+
+	std::vector<Node> nodes;
+	std::vector<RigidBody*> leaves;
+};
+
+template <typename F>
+void WideBVH::query(int root, const AABB& aabb, F&& callback, const RigidBody* filter) const
+{
+	if (root == nullNode)
+	{
+		return;
+	}
+
+	NodeStack s;
+	s.push(root);
+
+	while (!s.empty())
+	{
+		const Node& n = nodes[s.top()];
+		s.pop();
+
+		int mask = overlapMask(n, aabb);
+		if (filter)
+		{
+			mask &= filterMask(n, filter);
+		}
+
+		for (; mask != 0; mask &= mask - 1)
+		{
+			int ref = n.children[std::countr_zero(unsigned(mask))];
+
+			if (isLeafRef(ref))
+			{
+				callback(leaves[leafIndex(ref)]);
+			}
+			else
+			{
+				s.push(ref);
+			}
+		}
+	}
+}
+
+template <typename F>
+void WideBVH::cast(int root, const vec2& p, const vec2& d, const vec2& halfExtents, real maxFraction, F&& onLeaf) const
+{
+	if (root == nullNode)
+	{
+		return;
+	}
+
+	// Avoid dividing by zero for axis aligned segments. A large finite value is used
+	// rather than infinity, so that a segment lying on a slab boundary doesn't give NaN.
+	constexpr real large = 1e30f;
+	vec2 invD = { d.x != 0 ? 1 / d.x : large, d.y != 0 ? 1 / d.y : large };
+
+	NodeStack s;
+	s.push(root);
+
+	while (!s.empty())
+	{
+		const Node& n = nodes[s.top()];
+		s.pop();
+
+		int mask = castMask(n, p, invD, halfExtents, maxFraction);
+
+		while (mask != 0)
+		{
+			int ref = n.children[std::countr_zero(unsigned(mask))];
+			mask &= mask - 1;
+
+			if (isLeafRef(ref))
+			{
+				maxFraction = onLeaf(leaves[leafIndex(ref)]);
+
+				if (maxFraction <= 0)
+				{
+					return;
+				}
+
+				// The remaining children may now be beyond the clipped segment
+				mask &= castMask(n, p, invD, halfExtents, maxFraction);
+			}
+			else
+			{
+				s.push(ref);
+			}
+		}
+	}
+}